@@ -1,345 +1,6362 @@
-#include <iostream>
-#include <vector>
-#include <string>
-#include <ctime>
-#include <cmath>
-#include <algorithm>
-#include <memory>
-#include <iomanip>
-#include <map>
-#include <numeric>
-#include <sstream>
-#include <fstream>
-
-// Constants
-constexpr size_t MAX_LOADS = 10;
-constexpr double MAX_BATTERY_CHARGE_RATE = 0.2;
-constexpr double MAX_BATTERY_DISCHARGE_RATE = 0.3;
-constexpr double PANEL_DEGRADATION_THRESHOLD = 0.05; // 5% performance drop
-constexpr double TEMPERATURE_ALERT_THRESHOLD = 70.0; // °C
-constexpr double IRRADIANCE_EFFICIENCY_THRESHOLD = 0.7; // 70% of expected
-constexpr double CO2_SAVINGS_PER_KWH = 0.4; // kg CO2 per kWh saved
-constexpr double TREES_EQUIVALENT_PER_KWH = 0.01; // Trees equivalent per kWh saved
-
-// Data structures
-struct Load {
-    std::string name;
-    double power;
-    
-    Load(const std::string& n, double p) : name(n), power(p) {}
-};
-
-class SolarReading {
-public:
-    time_t timestamp;
-    double power_produced;
-    double power_consumed;
-    double battery_soc;
-    double irradiance;
-    double temperature;
-    double panel_voltage;
-    double panel_current;
-
-    SolarReading(double prod, double cons, double soc, double irr, double temp, 
-                double volt, double curr)
-        : timestamp(std::time(nullptr)),
-          power_produced(prod),
-          power_consumed(cons),
-          battery_soc(soc),
-          irradiance(irr),
-          temperature(temp),
-          panel_voltage(volt),
-          panel_current(curr) {}
-};
-
-// Maintenance Alert Types
-enum class AlertType {
-    PANEL_DEGRADATION,
-    HIGH_TEMPERATURE,
-    LOW_EFFICIENCY,
-    INVERTER_ISSUE,
-    BATTERY_DEGRADATION
-};
-
-class MaintenanceAlert {
-public:
-    AlertType type;
-    std::string message;
-    time_t timestamp;
-    double severity; // 0-1 scale
-
-    MaintenanceAlert(AlertType t, const std::string& msg, double sev)
-        : type(t), message(msg), timestamp(std::time(nullptr)), severity(sev) {}
-
-    void print() const {
-        std::cout << "[ALERT] " << message 
-                  << " | Severity: " << std::setprecision(2) << severity * 100 << "%"
-                  << " | Time: " << std::put_time(std::localtime(&timestamp), "%Y-%m-%d %H:%M:%S")
-                  << "\n";
-    }
-};
-
-class EnvironmentalImpact {
-    double total_energy_produced; // in kWh
-    time_t start_date;
-    
-public:
-    EnvironmentalImpact() : total_energy_produced(0), start_date(std::time(nullptr)) {}
-    
-    void addEnergy(double watts, double hours) {
-        total_energy_produced += (watts * hours) / 1000.0; // Convert to kWh
-    }
-    
-    double getCO2Savings() const {
-        return total_energy_produced * CO2_SAVINGS_PER_KWH;
-    }
-    
-    double getTreeEquivalents() const {
-        return total_energy_produced * TREES_EQUIVALENT_PER_KWH;
-    }
-    
-    void generateReport() const {
-        std::cout << "\n=== ENVIRONMENTAL IMPACT REPORT ===\n";
-        std::cout << "Total solar energy produced: " << total_energy_produced << " kWh\n";
-        std::cout << "CO2 emissions avoided: " << getCO2Savings() << " kg\n";
-        std::cout << "Equivalent to planting " << getTreeEquivalents() << " trees\n";
-        
-        // Generate HTML visualization
-        generateHTMLVisualization();
-    }
-    
-private:
-    void generateHTMLVisualization() const {
-        std::ofstream html_file("environmental_impact.html");
-        
-        html_file << R"(<!DOCTYPE html>
-<html>
-<head>
-    <title>Solar Energy Environmental Impact</title>
-    <script src="https://cdn.jsdelivr.net/npm/chart.js"></script>
-    <style>
-        .dashboard { display: flex; flex-wrap: wrap; gap: 20px; }
-        .chart-container { width: 45%; min-width: 300px; }
-    </style>
-</head>
-<body>
-    <h1>Solar Energy Environmental Impact</h1>
-    <div class="dashboard">
-        <div class="chart-container">
-            <canvas id="energyChart"></canvas>
-        </div>
-        <div class="chart-container">
-            <canvas id="co2Chart"></canvas>
-        </div>
-    </div>
-    <script>
-        const energyData = {
-            labels: ['Solar Energy Produced', 'Grid Energy Displaced'],
-            datasets: [{
-                data: [)" << total_energy_produced << ", " << total_energy_produced * 0.9 << R"(],
-                backgroundColor: ['#FFA500', '#DDDDDD']
-            }]
-        };
-        
-        const co2Data = {
-            labels: ['CO2 Emissions Avoided'],
-            datasets: [{
-                data: [)" << getCO2Savings() << R"(],
-                backgroundColor: ['#4BC0C0']
-            }]
-        };
-        
-        new Chart(document.getElementById('energyChart'), {
-            type: 'pie',
-            data: energyData,
-            options: { responsive: true, plugins: { title: { display: true, text: 'Energy Production (kWh)' } } }
-        });
-        
-        new Chart(document.getElementById('co2Chart'), {
-            type: 'bar',
-            data: co2Data,
-            options: { responsive: true, plugins: { title: { display: true, text: 'CO2 Savings (kg)' } } }
-        });
-    </script>
-</body>
-</html>)";
-        
-        html_file.close();
-        std::cout << "\nGenerated visualization: environmental_impact.html\n";
-    }
-};
-
-// Database Interface
-class Database {
-public:
-    virtual ~Database() = default;
-    virtual void storeReading(const SolarReading& reading) = 0;
-    virtual std::vector<SolarReading> getReadings(time_t start, time_t end) = 0;
-};
-
-// Mock Database implementation
-class MockDB : public Database {
-    std::vector<SolarReading> readings;
-public:
-    void storeReading(const SolarReading& reading) override {
-        readings.push_back(reading);
-        std::cout << "Stored reading at " << std::put_time(std::localtime(&reading.timestamp), "%Y-%m-%d %H:%M:%S") << "\n";
-    }
-    
-    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
-        std::vector<SolarReading> result;
-        for (const auto& reading : readings) {
-            if (reading.timestamp >= start && reading.timestamp <= end) {
-                result.push_back(reading);
-            }
-        }
-        return result;
-    }
-};
-
-class SolarOptimizer {
-    std::unique_ptr<Database> db;
-    std::vector<MaintenanceAlert> active_alerts;
-    std::map<time_t, double> historical_efficiency;
-    EnvironmentalImpact environmental_impact;
-    
-    // Calculate panel efficiency
-    double calculate_efficiency(double irradiance, double power_output) const {
-        if (irradiance <= 0) return 0.0;
-        const double expected_power = irradiance / 1000.0 * 300.0; // Assuming 300W panel
-        return power_output / expected_power;
-    }
-
-    // Maintenance check implementations...
-    void check_panel_degradation(const SolarReading& reading) {
-        double current_efficiency = calculate_efficiency(reading.irradiance, reading.power_produced);
-        historical_efficiency[reading.timestamp] = current_efficiency;
-        
-        if (historical_efficiency.size() < 30) return;
-
-        auto month_ago = reading.timestamp - 30 * 24 * 3600;
-        double sum = 0.0;
-        int count = 0;
-        
-        for (const auto& entry : historical_efficiency) {
-            if (entry.first >= month_ago && entry.first <= reading.timestamp) {
-                sum += entry.second;
-                count++;
-            }
-        }
-        
-        if (count == 0) return;
-        
-        double avg_efficiency = sum / count;
-        double degradation = 1.0 - (current_efficiency / avg_efficiency);
-        
-        if (degradation > PANEL_DEGRADATION_THRESHOLD) {
-            std::string msg = "Panel degradation detected: " + 
-                             std::to_string(static_cast<int>(degradation * 100)) + 
-                             "% performance loss";
-            active_alerts.emplace_back(
-                AlertType::PANEL_DEGRADATION, 
-                msg,
-                degradation / PANEL_DEGRADATION_THRESHOLD
-            );
-        }
-    }
-
-    void check_temperature_issues(const SolarReading& reading) {
-        if (reading.temperature > TEMPERATURE_ALERT_THRESHOLD) {
-            double severity = (reading.temperature - TEMPERATURE_ALERT_THRESHOLD) / 10.0;
-            severity = std::min(severity, 1.0);
-            
-            std::string msg = "High panel temperature: " + 
-                             std::to_string(static_cast<int>(reading.temperature)) + "°C";
-            active_alerts.emplace_back(
-                AlertType::HIGH_TEMPERATURE,
-                msg,
-                severity
-            );
-        }
-    }
-
-    // Other maintenance checks (efficiency, inverter, battery) would go here...
-
-public:
-    SolarOptimizer(std::unique_ptr<Database> database) : db(std::move(database)) {}
-    
-    void storeReading(const SolarReading& reading) {
-        db->storeReading(reading);
-        environmental_impact.addEnergy(reading.power_produced, 1.0); // Assuming 1 hour interval
-        performMaintenanceChecks(reading);
-    }
-    
-    // Previous methods (generateForecast, optimizeEnergyUsage) would go here...
-
-    void performMaintenanceChecks(const SolarReading& reading) {
-        // Clear old alerts
-        auto week_ago = std::time(nullptr) - 7 * 24 * 3600;
-        active_alerts.erase(
-            std::remove_if(active_alerts.begin(), active_alerts.end(),
-                [week_ago](const MaintenanceAlert& alert) {
-                    return alert.timestamp < week_ago;
-                }),
-            active_alerts.end()
-        );
-        
-        check_panel_degradation(reading);
-        check_temperature_issues(reading);
-        // Other checks would be called here...
-    }
-
-    void printMaintenanceAlerts() const {
-        if (active_alerts.empty()) {
-            std::cout << "No active maintenance alerts\n";
-            return;
-        }
-        
-        std::cout << "\n=== MAINTENANCE ALERTS ===\n";
-        for (const auto& alert : active_alerts) {
-            alert.print();
-        }
-    }
-    
-    void generateEnvironmentalReport() const {
-        environmental_impact.generateReport();
-    }
-};
-
-int main() {
-    auto mock_db = std::make_unique<MockDB>();
-    SolarOptimizer optimizer(std::move(mock_db));
-
-    int num_readings;
-    std::cout << "Enter the number of solar readings: ";
-    std::cin >> num_readings;
-
-    for (int i = 0; i < num_readings; ++i) {
-        double prod, cons, soc, irr, temp, volt, curr;
-        std::cout << "\nEnter data for Reading #" << (i + 1) << ":\n";
-
-        std::cout << "Power Produced (W): ";
-        std::cin >> prod;
-        std::cout << "Power Consumed (W): ";
-        std::cin >> cons;
-        std::cout << "Battery SOC (%): ";
-        std::cin >> soc;
-        std::cout << "Irradiance (W/m^2): ";
-        std::cin >> irr;
-        std::cout << "Temperature (°C): ";
-        std::cin >> temp;
-        std::cout << "Panel Voltage (V): ";
-        std::cin >> volt;
-        std::cout << "Panel Current (A): ";
-        std::cin >> curr;
-
-        SolarReading reading(prod, cons, soc, irr, temp, volt, curr);
-        optimizer.storeReading(reading);
-    }
-
-    // Generate reports
-    optimizer.printMaintenanceAlerts();
-    optimizer.generateEnvironmentalReport();
-
-    return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <ctime>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <iomanip>
+#include <map>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <fstream>
+#include <span>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <functional>
+#include <unordered_map>
+#include <queue>
+#include <deque>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <random>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <stdexcept>
+#include <limits>
+#include <bit>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SOLAR_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SOLAR_SIMD_NEON 1
+#endif
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <csignal>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#endif
+
+// Constants
+constexpr size_t MAX_LOADS = 10;
+constexpr double MAX_BATTERY_CHARGE_RATE = 0.2;
+constexpr double MAX_BATTERY_DISCHARGE_RATE = 0.3;
+constexpr double PANEL_DEGRADATION_THRESHOLD = 0.05; // 5% performance drop
+constexpr double TEMPERATURE_ALERT_THRESHOLD = 70.0; // °C
+constexpr double IRRADIANCE_EFFICIENCY_THRESHOLD = 0.7; // 70% of expected
+constexpr double INVERTER_EFFICIENCY_THRESHOLD = 0.9; // AC output / DC input
+constexpr double CO2_SAVINGS_PER_KWH = 0.4; // kg CO2 per kWh saved
+constexpr double TREES_EQUIVALENT_PER_KWH = 0.01; // Trees equivalent per kWh saved
+constexpr time_t DEGRADATION_WINDOW = 30 * 24 * 3600; // 30 days
+constexpr time_t DEGRADATION_BUCKET = 3600; // 1 hour resolution of the window
+constexpr time_t ALERT_RETENTION = 7 * 24 * 3600; // alerts expire a week after they last fired
+constexpr time_t MAX_SAMPLE_GAP = 15 * 60; // longer gaps between readings are treated as missing data
+constexpr time_t REORDER_WINDOW = 5 * 60; // readings may trail the newest by this much and still be checked in order
+constexpr size_t REORDER_CAPACITY = 1 << 16; // readings held per source before the oldest are released early
+constexpr time_t LATE_CORRECTION_HORIZON = 24 * 3600; // energy totals are corrected for readings up to this late
+constexpr double SKETCH_COMPRESSION = 50.0; // t-digest centroids per quantile sketch, roughly
+constexpr std::string_view CHECKPOINT_MAGIC = "SOLARCKP";
+constexpr uint32_t CHECKPOINT_VERSION = 6;
+constexpr time_t CHECKPOINT_INTERVAL = 300; // seconds of ingest between checkpoints
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov).
+// Capacity is rounded up to a power of two. Pushing into a full queue fails
+// instead of blocking so hot paths never wait on a consumer.
+template <typename T>
+class BoundedQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        cells.reset(new Cell[n]);
+        mask = n - 1;
+        for (size_t i = 0; i < n; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    ~BoundedQueue() {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        size_t end = enqueue_pos.load(std::memory_order_relaxed);
+        for (; pos != end; ++pos) {
+            Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_relaxed) == pos + 1) {
+                std::launder(reinterpret_cast<T*>(cell.storage))->~T();
+            }
+        }
+    }
+
+    template <typename... Args>
+    bool tryPush(Args&&... args) {
+        Cell* cell;
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        Cell* cell;
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        T* item = std::launder(reinterpret_cast<T*>(cell->storage));
+        out = std::move(*item);
+        item->~T();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t sizeApprox() const {
+        size_t enq = enqueue_pos.load(std::memory_order_relaxed);
+        size_t deq = dequeue_pos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// Logging
+enum class LogLevel : uint8_t { Debug, Info, Warning, Error, Off };
+
+enum class LogEvent : uint16_t {
+    READING_STORED
+};
+
+// Compact structured record; formatting happens on the logger thread
+struct LogRecord {
+    time_t timestamp;
+    double value;
+    LogEvent event;
+    LogLevel level;
+};
+
+// Asynchronous logger: callers push a LogRecord into a lock-free ring and a
+// background thread formats and writes in large buffered chunks. Records are
+// dropped (and counted) rather than blocking the caller when the ring is full.
+// The level can be set with SOLAR_LOG_LEVEL=debug|info|warning|error|off.
+class Logger {
+    BoundedQueue<LogRecord> queue;
+    std::atomic<LogLevel> min_level{LogLevel::Info};
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::FILE* out;
+    std::thread worker;
+
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO";
+            case LogLevel::Warning: return "WARN";
+            case LogLevel::Error: return "ERROR";
+            default: return "";
+        }
+    }
+
+    static void appendTime(std::string& buffer, time_t timestamp) {
+        std::tm tm{};
+        localtime_r(&timestamp, &tm);
+        char text[32];
+        size_t n = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+        buffer.append(text, n);
+    }
+
+    static void format(std::string& buffer, const LogRecord& record) {
+        if (record.level != LogLevel::Info) {
+            buffer += '[';
+            buffer += levelName(record.level);
+            buffer += "] ";
+        }
+        switch (record.event) {
+            case LogEvent::READING_STORED:
+                buffer += "Stored reading at ";
+                appendTime(buffer, record.timestamp);
+                break;
+        }
+        buffer += '\n';
+    }
+
+    void run() {
+        std::string buffer;
+        buffer.reserve(1 << 16);
+        LogRecord record{};
+        for (;;) {
+            uint64_t batch = 0;
+            while (buffer.size() < (1 << 16) && queue.tryPop(record)) {
+                format(buffer, record);
+                ++batch;
+            }
+            if (!buffer.empty()) {
+                std::fwrite(buffer.data(), 1, buffer.size(), out);
+                std::fflush(out);
+                buffer.clear();
+            }
+            if (batch > 0) {
+                written.fetch_add(batch, std::memory_order_release);
+                continue;
+            }
+            if (!running.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+public:
+    explicit Logger(std::FILE* output = stdout, size_t capacity = 1 << 14)
+        : queue(capacity), out(output) {
+        if (const char* env = std::getenv("SOLAR_LOG_LEVEL")) {
+            std::string name(env);
+            if (name == "debug") min_level = LogLevel::Debug;
+            else if (name == "info") min_level = LogLevel::Info;
+            else if (name == "warning") min_level = LogLevel::Warning;
+            else if (name == "error") min_level = LogLevel::Error;
+            else if (name == "off") min_level = LogLevel::Off;
+        }
+        worker = std::thread(&Logger::run, this);
+    }
+
+    ~Logger() {
+        running.store(false, std::memory_order_release);
+        worker.join();
+    }
+
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    void setLevel(LogLevel level) { min_level.store(level, std::memory_order_relaxed); }
+
+    bool enabled(LogLevel level) const {
+        return level >= min_level.load(std::memory_order_relaxed) && level != LogLevel::Off;
+    }
+
+    void log(LogLevel level, LogEvent event, time_t timestamp, double value = 0.0) {
+        if (!enabled(level)) return;
+        if (queue.tryPush(LogRecord{timestamp, value, event, level})) {
+            enqueued.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Wait until everything logged so far has been written
+    void flush() {
+        uint64_t target = enqueued.load(std::memory_order_relaxed);
+        while (written.load(std::memory_order_acquire) < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+// Flat binary encoding used by checkpoints (native byte order and layout, so
+// a checkpoint is only read back by the same build on the same platform).
+// Trivially copyable values are stored as their bytes; classes holding
+// containers provide save()/load() built from these.
+class CheckpointWriter {
+    std::string data;
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void putVector(std::span<const T> values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        put<uint64_t>(values.size());
+        data.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    std::string& buffer() { return data; }
+};
+
+class CheckpointReader {
+    std::string_view data;
+    size_t pos = 0;
+
+    void need(size_t bytes) const {
+        if (bytes > data.size() - pos) throw std::runtime_error("Truncated checkpoint");
+    }
+
+public:
+    explicit CheckpointReader(std::string_view bytes) : data(bytes) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        need(sizeof(T));
+        std::array<char, sizeof(T)> raw;
+        std::memcpy(raw.data(), data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return std::bit_cast<T>(raw);
+    }
+
+    template <typename T>
+    void getVector(std::vector<T>& values) {
+        const uint64_t n = get<uint64_t>();
+        if (n > (data.size() - pos) / sizeof(T)) throw std::runtime_error("Truncated checkpoint");
+        values.clear();
+        values.reserve(static_cast<size_t>(n));
+        for (uint64_t i = 0; i < n; ++i) values.push_back(get<T>());
+    }
+
+    bool done() const { return pos == data.size(); }
+};
+
+// Changes to a time-sorted container since its owner last took them, for a
+// copy kept in step elsewhere (the background checkpoint writer's mirror).
+// Applying replaces everything from changed_from on with items and then
+// drops entries before retained_from, so history that didn't change isn't
+// copied again. The owner lowers its changed_from mark on every write.
+template <typename Item>
+struct TailChanges {
+    time_t retained_from = std::numeric_limits<time_t>::max(); // oldest live entry; max when empty
+    time_t changed_from = std::numeric_limits<time_t>::min();
+    std::vector<Item> items;
+
+    // Entries of the sorted range [begin, end) from the mark on; resets the mark
+    template <typename It, typename Key>
+    static TailChanges take(It begin, It end, time_t& mark, Key key) {
+        TailChanges changes;
+        if (begin != end) changes.retained_from = key(*begin);
+        changes.changed_from = mark;
+        auto from = std::lower_bound(begin, end, mark, [&](const Item& item, time_t t) { return key(item) < t; });
+        changes.items.assign(from, end);
+        mark = std::numeric_limits<time_t>::max();
+        return changes;
+    }
+
+    template <typename Container, typename Key>
+    void applyTo(Container& target, Key key) && {
+        auto byKey = [&](const Item& item, time_t t) { return key(item) < t; };
+        target.erase(std::lower_bound(target.begin(), target.end(), changed_from, byKey), target.end());
+        target.insert(target.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+        target.erase(target.begin(), std::lower_bound(target.begin(), target.end(), retained_from, byKey));
+    }
+};
+
+// Built-in metrics, compiled in with -DSOLAR_ENABLE_METRICS=1. Every thread
+// updates its own shard (plain relaxed loads and stores, no shared cache
+// lines); a scrape sums the shards. Latencies go into log2 histograms of
+// nanoseconds. With metrics disabled the SOLAR_METRIC_* macros expand to
+// nothing, so instrumented code compiles exactly as uninstrumented code.
+#ifndef SOLAR_ENABLE_METRICS
+#define SOLAR_ENABLE_METRICS 0
+#endif
+
+#if SOLAR_ENABLE_METRICS
+enum class MetricCounter : size_t { READINGS_INGESTED, COUNT };
+enum class MetricHistogram : size_t { STORE_READING, STORE_BATCH, CHECKS, DB_WRITE, COUNT };
+
+class Metrics {
+    static constexpr size_t COUNTERS = static_cast<size_t>(MetricCounter::COUNT);
+    static constexpr size_t HISTOGRAMS = static_cast<size_t>(MetricHistogram::COUNT);
+    static constexpr size_t ALERT_TYPES = 5; // AlertType values
+    static constexpr size_t BUCKETS = 64;    // bucket i holds [2^i, 2^(i+1)) ns
+
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> sum_ns{0};
+    };
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, COUNTERS> counters{};
+        std::array<std::atomic<uint64_t>, ALERT_TYPES> alerts{};
+        std::array<Histogram, HISTOGRAMS> histograms{};
+    };
+
+    static constexpr std::array<const char*, COUNTERS> COUNTER_NAMES{"solar_readings_ingested_total"};
+    static constexpr std::array<const char*, HISTOGRAMS> HISTOGRAM_NAMES{
+        "solar_store_reading_seconds", "solar_store_batch_seconds", "solar_check_seconds",
+        "solar_db_write_seconds"};
+    static constexpr std::array<const char*, ALERT_TYPES> ALERT_NAMES{
+        "panel_degradation", "high_temperature", "low_efficiency", "inverter_issue", "battery_degradation"};
+
+    // Shards outlive their threads so counts from finished workers still scrape
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard* addShard() {
+        std::lock_guard<std::mutex> lock(mutex);
+        shards.push_back(std::make_unique<Shard>());
+        return shards.back().get();
+    }
+
+    static Shard& local() {
+        thread_local Shard* shard = instance().addShard();
+        return *shard;
+    }
+
+    // Only the owning thread writes a shard, so no read-modify-write is needed
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+public:
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    static void count(MetricCounter counter, uint64_t n = 1) {
+        bump(local().counters[static_cast<size_t>(counter)], n);
+    }
+
+    static void alert(size_t type) {
+        if (type < ALERT_TYPES) bump(local().alerts[type], 1);
+    }
+
+    static void observe(MetricHistogram histogram, uint64_t ns) {
+        Histogram& h = local().histograms[static_cast<size_t>(histogram)];
+        bump(h.buckets[ns == 0 ? 0 : static_cast<size_t>(std::bit_width(ns)) - 1], 1);
+        bump(h.sum_ns, ns);
+    }
+
+    // Prometheus text exposition format
+    void writePrometheus(std::ostream& os) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto total = [&](auto field) {
+            uint64_t sum = 0;
+            for (const auto& shard : shards) sum += field(*shard).load(std::memory_order_relaxed);
+            return sum;
+        };
+
+        for (size_t c = 0; c < COUNTERS; ++c) {
+            os << "# TYPE " << COUNTER_NAMES[c] << " counter\n"
+               << COUNTER_NAMES[c] << " " << total([&](Shard& s) -> auto& { return s.counters[c]; }) << "\n";
+        }
+        os << "# TYPE solar_alerts_raised_total counter\n";
+        for (size_t a = 0; a < ALERT_TYPES; ++a) {
+            os << "solar_alerts_raised_total{type=\"" << ALERT_NAMES[a] << "\"} "
+               << total([&](Shard& s) -> auto& { return s.alerts[a]; }) << "\n";
+        }
+        for (size_t h = 0; h < HISTOGRAMS; ++h) {
+            std::array<uint64_t, BUCKETS> buckets{};
+            size_t first = BUCKETS, used = 0;
+            for (size_t b = 0; b < BUCKETS; ++b) {
+                buckets[b] = total([&](Shard& s) -> auto& { return s.histograms[h].buckets[b]; });
+                if (buckets[b] > 0) {
+                    first = std::min(first, b);
+                    used = b + 1;
+                }
+            }
+            uint64_t cumulative = 0;
+            os << "# TYPE " << HISTOGRAM_NAMES[h] << " histogram\n";
+            for (size_t b = first; b < used; ++b) {
+                cumulative += buckets[b];
+                char le[32];
+                auto end = std::to_chars(le, le + sizeof(le), std::ldexp(1.0, static_cast<int>(b) + 1) / 1e9).ptr;
+                os << HISTOGRAM_NAMES[h] << "_bucket{le=\"" << std::string_view(le, static_cast<size_t>(end - le))
+                   << "\"} " << cumulative << "\n";
+            }
+            os << HISTOGRAM_NAMES[h] << "_bucket{le=\"+Inf\"} " << cumulative << "\n"
+               << HISTOGRAM_NAMES[h] << "_sum "
+               << static_cast<double>(total([&](Shard& s) -> auto& { return s.histograms[h].sum_ns; })) / 1e9 << "\n"
+               << HISTOGRAM_NAMES[h] << "_count " << cumulative << "\n";
+        }
+    }
+};
+
+// Records the lifetime of the enclosing scope into a histogram
+class MetricTimer {
+    MetricHistogram histogram;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+public:
+    explicit MetricTimer(MetricHistogram h) : histogram(h) {}
+    ~MetricTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::observe(histogram, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+#define SOLAR_METRIC_COUNT(counter, n) Metrics::count(MetricCounter::counter, n)
+#define SOLAR_METRIC_ALERT(type) Metrics::alert(static_cast<size_t>(type))
+#define SOLAR_METRIC_TIMER(histogram) MetricTimer solar_metric_timer_##histogram(MetricHistogram::histogram)
+#else
+#define SOLAR_METRIC_COUNT(counter, n) ((void)0)
+#define SOLAR_METRIC_ALERT(type) ((void)0)
+#define SOLAR_METRIC_TIMER(histogram) ((void)0)
+#endif
+
+// Data structures
+struct Load {
+    std::string name;
+    double power;
+    int priority; // value of running the load; higher runs first
+    
+    Load(const std::string& n, double p, int prio = 1) : name(n), power(p), priority(prio) {}
+};
+
+class SolarReading {
+public:
+    time_t timestamp;
+    double power_produced;
+    double power_consumed;
+    double battery_soc;
+    double irradiance;
+    double temperature;
+    double panel_voltage;
+    double panel_current;
+
+    SolarReading(double prod, double cons, double soc, double irr, double temp, 
+                double volt, double curr)
+        : timestamp(std::time(nullptr)),
+          power_produced(prod),
+          power_consumed(cons),
+          battery_soc(soc),
+          irradiance(irr),
+          temperature(temp),
+          panel_voltage(volt),
+          panel_current(curr) {}
+
+    SolarReading(time_t ts, double prod, double cons, double soc, double irr,
+                double temp, double volt, double curr)
+        : timestamp(ts),
+          power_produced(prod),
+          power_consumed(cons),
+          battery_soc(soc),
+          irradiance(irr),
+          temperature(temp),
+          panel_voltage(volt),
+          panel_current(curr) {}
+};
+
+// Maintenance Alert Types
+enum class AlertType {
+    PANEL_DEGRADATION,
+    HIGH_TEMPERATURE,
+    LOW_EFFICIENCY,
+    INVERTER_ISSUE,
+    BATTERY_DEGRADATION
+};
+
+inline const char* alertTypeName(AlertType type) {
+    switch (type) {
+        case AlertType::PANEL_DEGRADATION: return "panel degradation";
+        case AlertType::HIGH_TEMPERATURE: return "high temperature";
+        case AlertType::LOW_EFFICIENCY: return "low efficiency";
+        case AlertType::INVERTER_ISSUE: return "inverter issue";
+        case AlertType::BATTERY_DEGRADATION: return "battery degradation";
+    }
+    return "unknown";
+}
+
+// Alerts keep only their structured payload; the human-readable text is
+// produced on demand by print() or message(), so raising one never allocates.
+class MaintenanceAlert {
+public:
+    AlertType type;
+    double value;         // measured quantity that triggered the alert
+    double threshold;     // limit it was compared against
+    time_t timestamp;     // last occurrence
+    double severity;      // 0-1 scale, peak over all occurrences
+    uint32_t source = 0;  // site or panel the alert belongs to
+    time_t first_seen;
+    uint32_t count = 1;   // occurrences coalesced into this alert
+
+    MaintenanceAlert(AlertType t, double val, double limit, double sev, time_t ts, uint32_t src = 0)
+        : type(t), value(val), threshold(limit), timestamp(ts), severity(sev), source(src), first_seen(ts) {}
+
+    void writeMessage(std::ostream& os) const {
+        switch (type) {
+            case AlertType::PANEL_DEGRADATION:
+                os << "Panel degradation detected: " << static_cast<int>(value * 100) << "% performance loss";
+                break;
+            case AlertType::HIGH_TEMPERATURE:
+                os << "High panel temperature: " << static_cast<int>(value) << "°C";
+                break;
+            case AlertType::LOW_EFFICIENCY:
+                os << "Low panel efficiency: " << static_cast<int>(value * 100) << "% of expected output";
+                break;
+            case AlertType::INVERTER_ISSUE:
+                os << "Inverter losses: " << static_cast<int>(value * 100) << "% of DC power converted";
+                break;
+            case AlertType::BATTERY_DEGRADATION:
+                os << "Battery degradation: charge level changing " << static_cast<int>(std::fabs(value) * 100)
+                   << "%/h (limit " << static_cast<int>(threshold * 100) << "%/h)";
+                break;
+            default:
+                os << "Maintenance check failed: value " << value << " (threshold " << threshold << ")";
+                break;
+        }
+    }
+
+    std::string message() const {
+        std::ostringstream os;
+        writeMessage(os);
+        return os.str();
+    }
+
+    void print() const {
+        std::cout << "[ALERT] ";
+        writeMessage(std::cout);
+        std::cout << " | Severity: " << std::setprecision(2) << severity * 100 << "%"
+                  << " | Time: " << std::put_time(std::localtime(&timestamp), "%Y-%m-%d %H:%M:%S");
+        if (count > 1) {
+            std::cout << " | Occurrences: " << count << " since "
+                      << std::put_time(std::localtime(&first_seen), "%Y-%m-%d %H:%M:%S");
+        }
+        std::cout << "\n";
+    }
+};
+
+// Active alerts keyed by (AlertType, source). Repeats of an active alert are
+// coalesced into it (count, last time, peak severity and its payload) instead of adding
+// entries, so memory is bounded by the number of distinct keys. Expiry pops a
+// min-heap ordered by last occurrence; everything runs on the readings' own
+// timestamps so historical replay expires alerts the same way live data does.
+class AlertManager {
+    using Key = uint64_t;
+    using ExpiryEntry = std::pair<time_t, Key>;
+
+    // Index nodes come from a pool owned by the manager, so alerts that expire
+    // and fire again reuse memory instead of going back to the heap
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool =
+        std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    std::vector<MaintenanceAlert> alerts;
+    std::pmr::unordered_map<Key, size_t> index{pool.get()}; // key -> position in alerts
+    std::priority_queue<ExpiryEntry, std::vector<ExpiryEntry>, std::greater<>> expiry;
+    time_t retention;
+
+    static Key makeKey(AlertType type, uint32_t source) {
+        return (static_cast<Key>(source) << 8) | static_cast<Key>(type);
+    }
+
+    void rebuildIndex() {
+        index.clear();
+        for (size_t i = 0; i < alerts.size(); ++i) index.emplace(makeKey(alerts[i].type, alerts[i].source), i);
+    }
+
+    void remove(size_t pos) {
+        if (pos + 1 != alerts.size()) {
+            alerts[pos] = std::move(alerts.back());
+            index[makeKey(alerts[pos].type, alerts[pos].source)] = pos;
+        }
+        alerts.pop_back();
+    }
+
+public:
+    explicit AlertManager(time_t retention_seconds = ALERT_RETENTION) : retention(retention_seconds) {}
+
+    AlertManager(AlertManager&&) = default;
+
+    // Keeps this manager's pool: the index is rebuilt rather than moved, since
+    // its nodes must not outlive the pool they came from
+    AlertManager& operator=(AlertManager&& other) {
+        alerts = std::move(other.alerts);
+        expiry = std::move(other.expiry);
+        retention = other.retention;
+        rebuildIndex();
+        return *this;
+    }
+
+    void raise(AlertType type, uint32_t source, double severity, time_t timestamp,
+               double value, double threshold) {
+        SOLAR_METRIC_ALERT(type);
+        Key key = makeKey(type, source);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            MaintenanceAlert& alert = alerts[it->second];
+            ++alert.count;
+            alert.timestamp = std::max(alert.timestamp, timestamp);
+            if (severity >= alert.severity) {
+                alert.severity = severity;
+                alert.value = value;
+                alert.threshold = threshold;
+            }
+            return;
+        }
+        index.emplace(key, alerts.size());
+        alerts.emplace_back(type, value, threshold, severity, timestamp, source);
+        expiry.emplace(timestamp, key);
+    }
+
+    // Drop alerts that haven't fired within the retention period before `now`
+    void expire(time_t now) {
+        time_t cutoff = now - retention;
+        while (!expiry.empty() && expiry.top().first < cutoff) {
+            Key key = expiry.top().second;
+            expiry.pop();
+            auto it = index.find(key);
+            if (it == index.end()) continue;
+            const MaintenanceAlert& alert = alerts[it->second];
+            if (alert.timestamp < cutoff) {
+                size_t pos = it->second;
+                index.erase(it);
+                remove(pos);
+            } else {
+                expiry.emplace(alert.timestamp, key); // refreshed since it was queued
+            }
+        }
+    }
+
+    const std::vector<MaintenanceAlert>& active() const { return alerts; }
+    bool empty() const { return alerts.empty(); }
+    size_t size() const { return alerts.size(); }
+
+    void save(CheckpointWriter& out) const {
+        out.put(retention);
+        out.putVector<MaintenanceAlert>(alerts);
+    }
+
+    // The expiry queue is rebuilt with one entry per alert at its last
+    // occurrence, which expires exactly the same alerts as the original queue
+    void load(CheckpointReader& in) {
+        retention = in.get<time_t>();
+        in.getVector(alerts);
+        rebuildIndex();
+        expiry = {};
+        for (const auto& alert : alerts) expiry.emplace(alert.timestamp, makeKey(alert.type, alert.source));
+    }
+};
+
+// Integer division rounding toward negative infinity
+inline int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Mean over a sliding time window, kept as a ring of fixed-width time buckets
+// with a running sum and count. add() and mean() are amortized O(1) and memory
+// is bounded by the bucket count; the window edge is exact to one bucket.
+class RollingWindowMean {
+    struct Bucket {
+        int64_t index;
+        double sum;
+        uint64_t count;
+    };
+
+    std::vector<Bucket> buckets;
+    time_t bucket_width;
+    int64_t head;          // index of the newest bucket
+    double sum = 0.0;
+    uint64_t count = 0;
+
+    Bucket& slot(int64_t index) {
+        auto n = static_cast<int64_t>(buckets.size());
+        return buckets[static_cast<size_t>(((index % n) + n) % n)];
+    }
+
+    void evict(Bucket& bucket, int64_t new_index) {
+        if (bucket.count > 0) {
+            sum -= bucket.sum;
+            count -= bucket.count;
+        }
+        bucket = Bucket{new_index, 0.0, 0};
+    }
+
+    void advanceTo(int64_t index) {
+        auto n = static_cast<int64_t>(buckets.size());
+        if (index - head >= n) {
+            for (auto& bucket : buckets) bucket = Bucket{INT64_MIN, 0.0, 0};
+            sum = 0.0;
+            count = 0;
+        } else {
+            for (int64_t i = head + 1; i <= index; ++i) evict(slot(i), i);
+        }
+        int64_t previous = head;
+        head = index;
+
+        // Rebuild the running sum once per window length so subtraction error
+        // can't accumulate. Tying this to absolute bucket indices makes the
+        // state depend only on the buckets' contents, so a warm-up over the
+        // preceding data reproduces it exactly (see reanalyzeHistory).
+        if (floorDiv(previous, n) != floorDiv(index, n)) {
+            sum = 0.0;
+            for (const auto& bucket : buckets) sum += bucket.sum;
+        }
+    }
+
+public:
+    RollingWindowMean(time_t window, time_t width)
+        : buckets(static_cast<size_t>(std::max<time_t>(1, (window + width - 1) / width)),
+                  Bucket{INT64_MIN, 0.0, 0}),
+          bucket_width(width),
+          head(INT64_MIN) {}
+
+    void add(time_t timestamp, double value) {
+        int64_t index = floorDiv(timestamp, bucket_width);
+        if (head == INT64_MIN) {
+            head = index;
+        } else if (index > head) {
+            advanceTo(index);
+        } else if (index <= head - static_cast<int64_t>(buckets.size())) {
+            return; // older than the window
+        }
+
+        Bucket& bucket = slot(index);
+        if (bucket.index != index) evict(bucket, index);
+        bucket.sum += value;
+        ++bucket.count;
+        sum += value;
+        ++count;
+    }
+
+    double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+    uint64_t size() const { return count; }
+
+    void save(CheckpointWriter& out) const {
+        out.put(bucket_width);
+        out.put(head);
+        out.put(sum);
+        out.put(count);
+        out.putVector<Bucket>(buckets);
+    }
+
+    void load(CheckpointReader& in) {
+        bucket_width = in.get<time_t>();
+        head = in.get<int64_t>();
+        sum = in.get<double>();
+        count = in.get<uint64_t>();
+        in.getVector(buckets);
+        if (buckets.empty() || bucket_width <= 0) throw std::runtime_error("Corrupt checkpoint window");
+    }
+};
+
+// Tuning values of the maintenance checks
+struct CheckThresholds {
+    double panel_degradation = PANEL_DEGRADATION_THRESHOLD;
+    double temperature = TEMPERATURE_ALERT_THRESHOLD;
+    double low_efficiency = IRRADIANCE_EFFICIENCY_THRESHOLD;
+    double inverter_efficiency = INVERTER_EFFICIENCY_THRESHOLD;
+};
+
+// Per-site panel specs and tuning. The defaults are the compile-time constants;
+// a site overrides them with a key = value file loaded at startup:
+//   panel_rated_watts = 350
+//   temperature_alert_threshold = 75   # °C
+// Lines starting with # are comments. Unknown keys and bad values are errors.
+struct SiteConfig {
+    double panel_rated_watts = 300.0;
+    CheckThresholds thresholds;
+    double max_battery_charge_rate = MAX_BATTERY_CHARGE_RATE;
+    double max_battery_discharge_rate = MAX_BATTERY_DISCHARGE_RATE;
+    size_t max_loads = MAX_LOADS;
+    double battery_capacity_wh = 10000.0;
+    double battery_reserve_soc = 20.0; // %, never discharged below this
+    time_t reorder_window = REORDER_WINDOW; // s of lateness absorbed before readings reach the checks
+
+    static SiteConfig load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) throw std::runtime_error("Cannot open config " + path);
+
+        SiteConfig config;
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line)) {
+            ++line_number;
+            line = line.substr(0, line.find('#'));
+            auto eq = line.find('=');
+            auto trim = [](std::string text) {
+                text.erase(0, text.find_first_not_of(" \t\r"));
+                text.erase(text.find_last_not_of(" \t\r") + 1);
+                return text;
+            };
+            if (trim(line).empty()) continue;
+            std::string where = path + ":" + std::to_string(line_number);
+            if (eq == std::string::npos) throw std::runtime_error(where + ": expected key = value");
+
+            std::string key = trim(line.substr(0, eq));
+            std::string text = trim(line.substr(eq + 1));
+            double value = 0.0;
+            auto [end, err] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (err != std::errc() || end != text.data() + text.size()) {
+                throw std::runtime_error(where + ": bad value for " + key);
+            }
+
+            if (key == "panel_rated_watts") config.panel_rated_watts = value;
+            else if (key == "temperature_alert_threshold") config.thresholds.temperature = value;
+            else if (key == "panel_degradation_threshold") config.thresholds.panel_degradation = value;
+            else if (key == "irradiance_efficiency_threshold") config.thresholds.low_efficiency = value;
+            else if (key == "inverter_efficiency_threshold") config.thresholds.inverter_efficiency = value;
+            else if (key == "max_battery_charge_rate") config.max_battery_charge_rate = value;
+            else if (key == "max_battery_discharge_rate") config.max_battery_discharge_rate = value;
+            else if (key == "battery_capacity_wh") config.battery_capacity_wh = value;
+            else if (key == "battery_reserve_soc") config.battery_reserve_soc = value;
+            else if (key == "reorder_window") config.reorder_window = static_cast<time_t>(std::clamp(value, 0.0, 86400.0));
+            else if (key == "max_loads") config.max_loads = static_cast<size_t>(std::clamp(value, 0.0, double(MAX_LOADS)));
+            else throw std::runtime_error(where + ": unknown key " + key);
+        }
+        if (config.panel_rated_watts <= 0) throw std::runtime_error(path + ": panel_rated_watts must be positive");
+        return config;
+    }
+};
+
+// Site profiles: the per-reading checks are instantiated for the common panel
+// ratings with the default thresholds so those constants fold into the code;
+// any other configuration runs the same code with values read at runtime.
+enum class SiteProfile : uint8_t { RUNTIME, PANEL_300W, PANEL_350W, PANEL_400W, PANEL_450W };
+
+template <int RatedWatts>
+struct FixedPanelProfile {
+    static constexpr double ratedWatts(const SiteConfig&) { return RatedWatts; }
+    static constexpr double degradationLimit(const SiteConfig&) { return PANEL_DEGRADATION_THRESHOLD; }
+    static constexpr double temperatureLimit(const SiteConfig&) { return TEMPERATURE_ALERT_THRESHOLD; }
+    static constexpr double efficiencyLimit(const SiteConfig&) { return IRRADIANCE_EFFICIENCY_THRESHOLD; }
+    static constexpr double inverterLimit(const SiteConfig&) { return INVERTER_EFFICIENCY_THRESHOLD; }
+    static constexpr double chargeRate(const SiteConfig&) { return MAX_BATTERY_CHARGE_RATE; }
+    static constexpr double dischargeRate(const SiteConfig&) { return MAX_BATTERY_DISCHARGE_RATE; }
+};
+
+struct RuntimeSiteProfile {
+    static double ratedWatts(const SiteConfig& site) { return site.panel_rated_watts; }
+    static double degradationLimit(const SiteConfig& site) { return site.thresholds.panel_degradation; }
+    static double temperatureLimit(const SiteConfig& site) { return site.thresholds.temperature; }
+    static double efficiencyLimit(const SiteConfig& site) { return site.thresholds.low_efficiency; }
+    static double inverterLimit(const SiteConfig& site) { return site.thresholds.inverter_efficiency; }
+    static double chargeRate(const SiteConfig& site) { return site.max_battery_charge_rate; }
+    static double dischargeRate(const SiteConfig& site) { return site.max_battery_discharge_rate; }
+};
+
+inline SiteProfile matchSiteProfile(const SiteConfig& site) {
+    if (site.thresholds.panel_degradation != PANEL_DEGRADATION_THRESHOLD ||
+        site.thresholds.temperature != TEMPERATURE_ALERT_THRESHOLD ||
+        site.thresholds.low_efficiency != IRRADIANCE_EFFICIENCY_THRESHOLD ||
+        site.thresholds.inverter_efficiency != INVERTER_EFFICIENCY_THRESHOLD ||
+        site.max_battery_charge_rate != MAX_BATTERY_CHARGE_RATE ||
+        site.max_battery_discharge_rate != MAX_BATTERY_DISCHARGE_RATE) {
+        return SiteProfile::RUNTIME;
+    }
+    if (site.panel_rated_watts == 300.0) return SiteProfile::PANEL_300W;
+    if (site.panel_rated_watts == 350.0) return SiteProfile::PANEL_350W;
+    if (site.panel_rated_watts == 400.0) return SiteProfile::PANEL_400W;
+    if (site.panel_rated_watts == 450.0) return SiteProfile::PANEL_450W;
+    return SiteProfile::RUNTIME;
+}
+
+// Calls f with the profile type matching `profile`
+template <typename F>
+decltype(auto) withSiteProfile(SiteProfile profile, F&& f) {
+    switch (profile) {
+        case SiteProfile::PANEL_300W: return f(FixedPanelProfile<300>{});
+        case SiteProfile::PANEL_350W: return f(FixedPanelProfile<350>{});
+        case SiteProfile::PANEL_400W: return f(FixedPanelProfile<400>{});
+        case SiteProfile::PANEL_450W: return f(FixedPanelProfile<450>{});
+        default: return f(RuntimeSiteProfile{});
+    }
+}
+
+struct ActiveSiteConfig {
+    SiteConfig site;
+    SiteProfile profile;
+};
+
+// Streaming state of the panel degradation check: each efficiency sample is
+// compared with the mean over the trailing DEGRADATION_WINDOW
+class DegradationTracker {
+    RollingWindowMean history{DEGRADATION_WINDOW, DEGRADATION_BUCKET};
+    uint64_t samples;
+
+public:
+    static constexpr uint64_t MIN_SAMPLES = 30;
+    static constexpr int64_t WINDOW_BUCKETS = (DEGRADATION_WINDOW + DEGRADATION_BUCKET - 1) / DEGRADATION_BUCKET;
+
+    explicit DegradationTracker(uint64_t samples_before = 0) : samples(samples_before) {}
+
+    // Adds the sample and returns its degradation relative to the window
+    // mean, or NaN while there isn't enough history yet
+    double update(time_t timestamp, double efficiency) {
+        history.add(timestamp, efficiency);
+        ++samples;
+        if (samples < MIN_SAMPLES || history.size() == 0) return std::nan("");
+        return 1.0 - (efficiency / history.mean());
+    }
+
+    // Rebuild window state from earlier data without counting it as new samples
+    void warmUp(time_t timestamp, double efficiency) { history.add(timestamp, efficiency); }
+
+    const RollingWindowMean& window() const { return history; }
+
+    void save(CheckpointWriter& out) const {
+        history.save(out);
+        out.put(samples);
+    }
+
+    void load(CheckpointReader& in) {
+        history.load(in);
+        samples = in.get<uint64_t>();
+    }
+};
+
+inline double degradationSeverity(double degradation, double threshold) {
+    return degradation / threshold;
+}
+
+inline double temperatureSeverity(double temperature, double threshold) {
+    return std::min((temperature - threshold) / 10.0, 1.0);
+}
+
+// Shortfall below a ratio threshold, 1.0 when nothing gets through
+inline double ratioSeverity(double ratio, double threshold) {
+    return std::clamp((threshold - ratio) / threshold, 0.0, 1.0);
+}
+
+// Excess of a rate over its limit, saturating at twice the limit
+inline double rateSeverity(double rate, double limit) {
+    return std::min((rate - limit) / limit, 1.0);
+}
+
+// Exponentially weighted mean that reports NaN until it has seen warmup samples
+class Ewma {
+    double alpha;
+    uint32_t warmup;
+    double value = 0.0;
+    uint32_t samples = 0;
+
+public:
+    Ewma(double smoothing, uint32_t warmup_samples) : alpha(smoothing), warmup(warmup_samples) {}
+
+    double update(double x) {
+        value = samples == 0 ? x : value + alpha * (x - value);
+        if (samples < warmup) ++samples;
+        return samples < warmup ? std::nan("") : value;
+    }
+};
+
+// Output relative to what the irradiance should give, smoothed so a passing
+// cloud edge doesn't alert. Low light is skipped: the ratio is noise there.
+class EfficiencyTracker {
+    Ewma ratio{1.0 / 16, 16};
+
+public:
+    static constexpr double MIN_IRRADIANCE = 200.0; // W/m²
+
+    double update(double irradiance, double efficiency) {
+        if (!(irradiance >= MIN_IRRADIANCE)) return std::nan("");
+        return ratio.update(efficiency);
+    }
+};
+
+// Inverter conversion ratio: AC power produced over DC power at the panel
+// terminals (panel_voltage * panel_current), smoothed the same way
+class InverterTracker {
+    Ewma ratio{1.0 / 16, 16};
+
+public:
+    static constexpr double MIN_DC_POWER = 50.0; // W
+
+    double update(double dc_power, double ac_power) {
+        if (!(dc_power >= MIN_DC_POWER)) return std::nan("");
+        return ratio.update(ac_power / dc_power);
+    }
+};
+
+// Battery state-of-charge slope in capacity fractions per hour, measured over
+// spans of at least SPAN seconds. A battery that charges or discharges faster
+// than the inverter's rate limits allow has lost capacity.
+class BatteryRateTracker {
+    time_t anchor_time = 0;
+    double anchor_soc = 0.0;
+    bool anchored = false;
+
+public:
+    static constexpr time_t SPAN = 15 * 60;
+
+    // Returns the slope when a span completes, NaN otherwise
+    double update(time_t timestamp, double soc_percent) {
+        if (!anchored || timestamp < anchor_time || timestamp - anchor_time > SPAN + MAX_SAMPLE_GAP) {
+            anchor_time = timestamp;
+            anchor_soc = soc_percent;
+            anchored = true;
+            return std::nan("");
+        }
+        const time_t elapsed = timestamp - anchor_time;
+        if (elapsed < SPAN) return std::nan("");
+        double slope = (soc_percent - anchor_soc) / 100.0 / (static_cast<double>(elapsed) / 3600.0);
+        anchor_time = timestamp;
+        anchor_soc = soc_percent;
+        return slope;
+    }
+};
+
+// Maintenance-check pipeline. Each stage owns its streaming state and sees
+// every reading once through check(); DetectorPipeline calls the stages in
+// order from a fold expression, so a whole pipeline inlines into the caller's
+// loop with no per-check dispatch. A stage looks like
+//   struct MyStage {
+//       template <typename Profile>
+//       void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink);
+//   };
+// Limits come through Profile, so fixed site profiles fold them into constants.
+
+// Per-reading values shared by all stages; precomputed once, in bulk for batches
+struct CheckInput {
+    const SolarReading& reading;
+    double efficiency;     // output relative to rated power at this irradiance
+    bool over_temperature; // reading.temperature above the site's limit
+};
+
+// Where stages report: raises into the owning site's alert table
+struct AlertSink {
+    AlertManager& alerts;
+    uint32_t source;
+
+    void raise(AlertType type, double severity, time_t timestamp, double value, double threshold) {
+        alerts.raise(type, source, severity, timestamp, value, threshold);
+    }
+};
+
+struct DegradationStage {
+    DegradationTracker tracker;
+
+    void save(CheckpointWriter& out) const { tracker.save(out); }
+    void load(CheckpointReader& in) { tracker.load(in); }
+
+    template <typename Profile>
+    void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink) {
+        const double limit = Profile::degradationLimit(site);
+        double degradation = tracker.update(in.reading.timestamp, in.efficiency);
+        if (degradation > limit) {
+            sink.raise(AlertType::PANEL_DEGRADATION, degradationSeverity(degradation, limit),
+                       in.reading.timestamp, degradation, limit);
+        }
+    }
+};
+
+struct LowEfficiencyStage {
+    EfficiencyTracker tracker;
+
+    template <typename Profile>
+    void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink) {
+        const double limit = Profile::efficiencyLimit(site);
+        double ratio = tracker.update(in.reading.irradiance, in.efficiency);
+        if (ratio < limit) {
+            sink.raise(AlertType::LOW_EFFICIENCY, ratioSeverity(ratio, limit), in.reading.timestamp, ratio, limit);
+        }
+    }
+};
+
+struct InverterStage {
+    InverterTracker tracker;
+
+    template <typename Profile>
+    void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink) {
+        const double limit = Profile::inverterLimit(site);
+        const SolarReading& r = in.reading;
+        double ratio = tracker.update(r.panel_voltage * r.panel_current, r.power_produced);
+        if (ratio < limit) {
+            sink.raise(AlertType::INVERTER_ISSUE, ratioSeverity(ratio, limit), r.timestamp, ratio, limit);
+        }
+    }
+};
+
+struct BatteryStage {
+    BatteryRateTracker tracker;
+
+    template <typename Profile>
+    void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink) {
+        double slope = tracker.update(in.reading.timestamp, in.reading.battery_soc);
+        double limit = slope >= 0 ? Profile::chargeRate(site) : Profile::dischargeRate(site);
+        if (std::fabs(slope) > limit) {
+            sink.raise(AlertType::BATTERY_DEGRADATION, rateSeverity(std::fabs(slope), limit),
+                       in.reading.timestamp, slope, limit);
+        }
+    }
+};
+
+struct TemperatureStage {
+    template <typename Profile>
+    void check(const CheckInput& in, const SiteConfig& site, Profile, AlertSink& sink) {
+        if (!in.over_temperature) return;
+        const double limit = Profile::temperatureLimit(site);
+        sink.raise(AlertType::HIGH_TEMPERATURE, temperatureSeverity(in.reading.temperature, limit),
+                   in.reading.timestamp, in.reading.temperature, limit);
+    }
+};
+
+template <typename... Stages>
+class DetectorPipeline {
+    std::tuple<Stages...> stages;
+
+    template <typename Stage>
+    static void saveStage(CheckpointWriter& out, const Stage& stage) {
+        if constexpr (requires { stage.save(out); }) {
+            stage.save(out);
+        } else {
+            static_assert(std::is_trivially_copyable_v<Stage>, "stage needs save()/load()");
+            out.put(stage);
+        }
+    }
+
+    template <typename Stage>
+    static void loadStage(CheckpointReader& in, Stage& stage) {
+        if constexpr (requires { stage.load(in); }) {
+            stage.load(in);
+        } else {
+            stage = in.get<Stage>();
+        }
+    }
+
+public:
+    template <typename Profile>
+    void run(const CheckInput& in, const SiteConfig& site, Profile profile, AlertSink& sink) {
+        std::apply([&](auto&... stage) { (stage.check(in, site, profile, sink), ...); }, stages);
+    }
+
+    // Stages with containers provide save()/load(); the rest are stored as bytes
+    void save(CheckpointWriter& out) const {
+        std::apply([&](const auto&... stage) { (saveStage(out, stage), ...); }, stages);
+    }
+
+    void load(CheckpointReader& in) {
+        std::apply([&](auto&... stage) { (loadStage(in, stage), ...); }, stages);
+    }
+
+    template <typename Stage>
+    Stage& stage() { return std::get<Stage>(stages); }
+
+    template <typename Stage>
+    const Stage& stage() const { return std::get<Stage>(stages); }
+};
+
+using StandardChecks = DetectorPipeline<DegradationStage, LowEfficiencyStage, InverterStage,
+                                        BatteryStage, TemperatureStage>;
+
+// Neumaier compensated summation: the rounding error of every addition is
+// carried separately, so billions of small terms don't drift
+class CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+public:
+    void add(double value) {
+        double t = sum + value;
+        if (std::fabs(sum) >= std::fabs(value)) compensation += (sum - t) + value;
+        else compensation += (value - t) + sum;
+        sum = t;
+    }
+
+    void merge(const CompensatedSum& other) {
+        add(other.sum);
+        add(other.compensation);
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+// Replace path with data in one step: write a temporary file beside it,
+// flush it to disk and rename it over the target, so readers see either the
+// old or the new file and never a partial one
+inline bool writeFileAtomically(const std::string& path, std::string_view data) {
+    const std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    bool ok = ::fdatasync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+struct PowerSample {
+    time_t timestamp;
+    double watts;
+};
+
+// The last `horizon` seconds of a source's power samples, in time order, so
+// a reading that arrives after its neighbours were integrated can be spliced
+// in between them. Appends and near-the-end inserts are O(1).
+class PowerHistory {
+    std::deque<PowerSample> samples;
+    time_t horizon;
+    time_t changed_from = std::numeric_limits<time_t>::min(); // see takeChanges()
+
+public:
+    enum class Splice { INSERTED, DUPLICATE, TOO_OLD };
+
+    explicit PowerHistory(time_t span = LATE_CORRECTION_HORIZON) : horizon(span) {}
+
+    // Next sample of the in-order stream; repeats of the newest timestamp are ignored
+    void append(time_t timestamp, double watts) {
+        if (!samples.empty() && timestamp <= samples.back().timestamp) return;
+        changed_from = std::min(changed_from, timestamp);
+        samples.push_back({timestamp, watts});
+        while (samples.front().timestamp < timestamp - horizon) samples.pop_front();
+    }
+
+    // Insert a late sample, reporting the neighbours it was placed between
+    Splice insert(PowerSample late, std::optional<PowerSample>& prev, std::optional<PowerSample>& next) {
+        if (samples.empty() || late.timestamp < samples.back().timestamp - horizon) return Splice::TOO_OLD;
+        auto it = std::lower_bound(samples.begin(), samples.end(), late.timestamp,
+                                   [](const PowerSample& s, time_t t) { return s.timestamp < t; });
+        if (it != samples.end() && it->timestamp == late.timestamp) return Splice::DUPLICATE;
+        if (it != samples.begin()) prev = *(it - 1);
+        if (it != samples.end()) next = *it;
+        changed_from = std::min(changed_from, late.timestamp);
+        samples.insert(it, late);
+        return Splice::INSERTED;
+    }
+
+    void save(CheckpointWriter& out) const {
+        out.put(horizon);
+        std::vector<PowerSample> flat(samples.begin(), samples.end());
+        out.putVector<PowerSample>(flat);
+    }
+
+    void load(CheckpointReader& in) {
+        horizon = in.get<time_t>();
+        std::vector<PowerSample> flat;
+        in.getVector(flat);
+        samples.assign(flat.begin(), flat.end());
+        changed_from = std::numeric_limits<time_t>::min();
+    }
+
+    struct Changes {
+        time_t horizon;
+        TailChanges<PowerSample> samples;
+    };
+
+    // Samples added since the previous call (all of them the first time); a
+    // history given every Changes in order by applyChanges() saves the same bytes
+    Changes takeChanges() {
+        return {horizon, TailChanges<PowerSample>::take(samples.begin(), samples.end(), changed_from,
+                                                        [](const PowerSample& s) { return s.timestamp; })};
+    }
+
+    void applyChanges(Changes&& changes) {
+        horizon = changes.horizon;
+        std::move(changes.samples).applyTo(samples, [](const PowerSample& s) { return s.timestamp; });
+    }
+};
+
+// Readings that reached the correction path
+struct LateReadingStats {
+    uint64_t corrected = 0;   // spliced into energy totals and rollups
+    uint64_t uncorrected = 0; // beyond LATE_CORRECTION_HORIZON: stored, statistics only
+    uint64_t duplicates = 0;  // samples already seen, dropped
+};
+
+// Per-source reorder buffer. Readings are held sorted by timestamp (arrival
+// order within a timestamp) and released once the watermark, the newest
+// timestamp seen minus the allowed lateness, has passed them, or early,
+// oldest first, when more than `capacity` are held. A reading older than
+// the last one released is refused as late. Nearly ordered input is an
+// append at the back.
+class ReorderBuffer {
+    std::deque<SolarReading> held;
+    size_t capacity;
+    time_t newest = std::numeric_limits<time_t>::min();
+    time_t released_through = std::numeric_limits<time_t>::min();
+
+    void releaseFront(std::vector<SolarReading>& out) {
+        released_through = held.front().timestamp;
+        out.push_back(held.front());
+        held.pop_front();
+    }
+
+public:
+    explicit ReorderBuffer(size_t max_held = REORDER_CAPACITY) : capacity(std::max<size_t>(1, max_held)) {}
+
+    // False if the reading is late, i.e. older than one already released
+    bool push(const SolarReading& reading) {
+        if (reading.timestamp < released_through) return false;
+        newest = std::max(newest, reading.timestamp);
+        if (held.empty() || reading.timestamp >= held.back().timestamp) {
+            held.push_back(reading);
+        } else {
+            auto pos = std::upper_bound(held.begin(), held.end(), reading.timestamp,
+                                        [](time_t t, const SolarReading& r) { return t < r.timestamp; });
+            held.insert(pos, reading);
+        }
+        return true;
+    }
+
+    // Append the readings the watermark has passed to out, in time order
+    void release(time_t lateness, std::vector<SolarReading>& out) {
+        while (!held.empty() && (held.front().timestamp <= newest - lateness || held.size() > capacity)) {
+            releaseFront(out);
+        }
+    }
+
+    // Append everything held (end of stream)
+    void releaseAll(std::vector<SolarReading>& out) {
+        while (!held.empty()) releaseFront(out);
+    }
+
+    // Treat readings up to timestamp as released elsewhere, dropping any held
+    void markReleased(time_t timestamp) {
+        while (!held.empty() && held.front().timestamp <= timestamp) held.pop_front();
+        released_through = std::max(released_through, timestamp);
+        newest = std::max(newest, timestamp);
+    }
+
+    time_t releasedThrough() const { return released_through; }
+    size_t size() const { return held.size(); }
+
+    void save(CheckpointWriter& out) const {
+        out.put(newest);
+        out.put(released_through);
+        std::vector<SolarReading> flat(held.begin(), held.end());
+        out.putVector<SolarReading>(flat);
+    }
+
+    void load(CheckpointReader& in) {
+        newest = in.get<time_t>();
+        released_through = in.get<time_t>();
+        std::vector<SolarReading> flat;
+        in.getVector(flat);
+        held.assign(flat.begin(), flat.end());
+    }
+};
+
+class EnvironmentalImpact {
+    // Last sample of a source, the left end of its next integration interval
+    struct SourceState {
+        time_t timestamp;
+        double watts;
+    };
+
+    CompensatedSum total_energy_produced; // in kWh
+    time_t start_date;
+    std::unordered_map<uint32_t, SourceState> sources;
+    uint32_t cached_id = 0;
+    SourceState* cached_source = nullptr; // most sites feed a single source
+    
+public:
+    EnvironmentalImpact() : start_date(std::time(nullptr)) {}
+
+    EnvironmentalImpact(const EnvironmentalImpact& other)
+        : total_energy_produced(other.total_energy_produced),
+          start_date(other.start_date),
+          sources(other.sources) {}
+
+    EnvironmentalImpact& operator=(const EnvironmentalImpact& other) {
+        total_energy_produced = other.total_energy_produced;
+        start_date = other.start_date;
+        sources = other.sources;
+        cached_source = nullptr;
+        return *this;
+    }
+    
+    void addEnergy(double watts, double hours) {
+        total_energy_produced.add((watts * hours) / 1000.0); // Convert to kWh
+    }
+
+    // Integrate a source's power over the time since its previous sample with
+    // the trapezoidal rule. Gaps longer than MAX_SAMPLE_GAP are treated as
+    // missing data, and samples that aren't newer than the last one are ignored.
+    void addSample(uint32_t source, time_t timestamp, double watts) {
+        if (!cached_source || cached_id != source) {
+            auto [it, inserted] = sources.try_emplace(source, SourceState{timestamp, watts});
+            cached_id = source;
+            cached_source = &it->second;
+            if (inserted) return;
+        }
+        SourceState& state = *cached_source;
+        if (timestamp <= state.timestamp) return;
+        time_t dt = timestamp - state.timestamp;
+        if (dt <= MAX_SAMPLE_GAP) {
+            addEnergy((state.watts + watts) / 2.0, static_cast<double>(dt) / 3600.0);
+        }
+        state = SourceState{timestamp, watts};
+    }
+
+    // Splice a late sample between its neighbours: the energy of the
+    // prev -> next segment is replaced by prev -> late -> next
+    void spliceSample(const std::optional<PowerSample>& prev, PowerSample late,
+                      const std::optional<PowerSample>& next) {
+        auto segment = [&](PowerSample a, PowerSample b, double sign) {
+            time_t dt = b.timestamp - a.timestamp;
+            if (dt > 0 && dt <= MAX_SAMPLE_GAP) addEnergy(sign * (a.watts + b.watts) / 2.0, static_cast<double>(dt) / 3600.0);
+        };
+        if (prev) segment(*prev, late, 1.0);
+        if (next) segment(late, *next, 1.0);
+        if (prev && next) segment(*prev, *next, -1.0);
+    }
+
+    // Fold another site's totals into this one
+    void merge(const EnvironmentalImpact& other) {
+        total_energy_produced.merge(other.total_energy_produced);
+        start_date = std::min(start_date, other.start_date);
+    }
+
+    void save(CheckpointWriter& out) const {
+        out.put(total_energy_produced);
+        out.put(start_date);
+        out.put<uint64_t>(sources.size());
+        for (const auto& [id, state] : sources) {
+            out.put(id);
+            out.put(state);
+        }
+    }
+
+    void load(CheckpointReader& in) {
+        total_energy_produced = in.get<CompensatedSum>();
+        start_date = in.get<time_t>();
+        sources.clear();
+        cached_source = nullptr;
+        for (uint64_t n = in.get<uint64_t>(); n > 0; --n) {
+            uint32_t id = in.get<uint32_t>();
+            sources.emplace(id, in.get<SourceState>());
+        }
+    }
+
+    double getTotalEnergy() const { return total_energy_produced.value(); }
+    
+    double getCO2Savings() const {
+        return getTotalEnergy() * CO2_SAVINGS_PER_KWH;
+    }
+    
+    double getTreeEquivalents() const {
+        return getTotalEnergy() * TREES_EQUIVALENT_PER_KWH;
+    }
+    
+    void generateReport() const {
+        std::cout << "\n=== ENVIRONMENTAL IMPACT REPORT ===\n";
+        std::cout << "Total solar energy produced: " << getTotalEnergy() << " kWh\n";
+        std::cout << "CO2 emissions avoided: " << getCO2Savings() << " kg\n";
+        std::cout << "Equivalent to planting " << getTreeEquivalents() << " trees\n";
+        
+        // Generate HTML visualization
+        generateHTMLVisualization();
+    }
+    
+private:
+    void generateHTMLVisualization() const {
+        std::ostringstream html_file;
+        
+        html_file << R"(<!DOCTYPE html>
+<html>
+<head>
+    <title>Solar Energy Environmental Impact</title>
+    <script src="https://cdn.jsdelivr.net/npm/chart.js"></script>
+    <style>
+        .dashboard { display: flex; flex-wrap: wrap; gap: 20px; }
+        .chart-container { width: 45%; min-width: 300px; }
+    </style>
+</head>
+<body>
+    <h1>Solar Energy Environmental Impact</h1>
+    <div class="dashboard">
+        <div class="chart-container">
+            <canvas id="energyChart"></canvas>
+        </div>
+        <div class="chart-container">
+            <canvas id="co2Chart"></canvas>
+        </div>
+    </div>
+    <script>
+        const energyData = {
+            labels: ['Solar Energy Produced', 'Grid Energy Displaced'],
+            datasets: [{
+                data: [)" << getTotalEnergy() << ", " << getTotalEnergy() * 0.9 << R"(],
+                backgroundColor: ['#FFA500', '#DDDDDD']
+            }]
+        };
+        
+        const co2Data = {
+            labels: ['CO2 Emissions Avoided'],
+            datasets: [{
+                data: [)" << getCO2Savings() << R"(],
+                backgroundColor: ['#4BC0C0']
+            }]
+        };
+        
+        new Chart(document.getElementById('energyChart'), {
+            type: 'pie',
+            data: energyData,
+            options: { responsive: true, plugins: { title: { display: true, text: 'Energy Production (kWh)' } } }
+        });
+        
+        new Chart(document.getElementById('co2Chart'), {
+            type: 'bar',
+            data: co2Data,
+            options: { responsive: true, plugins: { title: { display: true, text: 'CO2 Savings (kg)' } } }
+        });
+    </script>
+</body>
+</html>)";
+        
+        if (!writeFileAtomically("environmental_impact.html", html_file.view())) {
+            std::cerr << "Cannot write environmental_impact.html: " << std::strerror(errno) << "\n";
+            return;
+        }
+        std::cout << "\nGenerated visualization: environmental_impact.html\n";
+    }
+};
+
+// Running sum/min/max of one metric inside a rollup bucket
+struct RollupStat {
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double value) {
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+
+    void merge(const RollupStat& other) {
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+};
+
+// Aggregate of the readings whose timestamps fall in [start, start + resolution)
+struct RollupBucket {
+    time_t start = 0;
+    uint64_t count = 0;
+    double energy_wh = 0.0; // production integrated over the part of the bucket covered by data
+    RollupStat power_produced;
+    RollupStat power_consumed;
+    RollupStat irradiance;
+    RollupStat temperature;
+    RollupStat battery_soc;
+
+    void add(const SolarReading& reading) {
+        ++count;
+        power_produced.add(reading.power_produced);
+        power_consumed.add(reading.power_consumed);
+        irradiance.add(reading.irradiance);
+        temperature.add(reading.temperature);
+        battery_soc.add(reading.battery_soc);
+    }
+
+    void merge(const RollupBucket& other) {
+        count += other.count;
+        energy_wh += other.energy_wh;
+        power_produced.merge(other.power_produced);
+        power_consumed.merge(other.power_consumed);
+        irradiance.merge(other.irradiance);
+        temperature.merge(other.temperature);
+        battery_soc.merge(other.battery_soc);
+    }
+
+    double mean(const RollupStat& stat) const { return count > 0 ? stat.sum / static_cast<double>(count) : 0.0; }
+};
+
+struct RollupRange {
+    time_t resolution = 0;
+    std::span<const RollupBucket> buckets;
+};
+
+// Incremental 1-minute, 1-hour and 1-day rollups of one source's readings.
+// Energy is integrated with the trapezoidal rule between consecutive readings
+// and split exactly at bucket boundaries; gaps over MAX_SAMPLE_GAP contribute
+// nothing. Late readings update the statistics of their bucket but not the
+// energy, which is only integrated along the in-order stream.
+// Time ranges are half-open: [start, end).
+class RollupStore {
+public:
+    static constexpr size_t LEVELS = 3;
+    static constexpr std::array<time_t, LEVELS> RESOLUTIONS{60, 3600, 86400};
+
+private:
+    struct Level {
+        time_t resolution;
+        time_t retention;
+        std::vector<RollupBucket> buckets;
+        size_t first = 0; // buckets before this index have been pruned
+        time_t changed_from = std::numeric_limits<time_t>::min(); // see takeChanges()
+    };
+
+    std::array<Level, LEVELS> levels;
+    time_t last_timestamp = 0;
+    double last_power = 0.0;
+    bool has_last = false;
+
+    static time_t alignDown(time_t t, time_t resolution) {
+        time_t q = t / resolution;
+        if (t % resolution != 0 && t < 0) --q;
+        return q * resolution;
+    }
+
+    RollupBucket& bucketAt(Level& level, time_t start) {
+        level.changed_from = std::min(level.changed_from, start);
+        auto& buckets = level.buckets;
+        if (buckets.size() == level.first || buckets.back().start < start) {
+            RollupBucket bucket;
+            bucket.start = start;
+            buckets.push_back(bucket);
+            prune(level);
+            return buckets.back();
+        }
+        if (buckets.back().start == start) return buckets.back();
+
+        auto it = std::lower_bound(buckets.begin() + static_cast<std::ptrdiff_t>(level.first), buckets.end(), start,
+                                   [](const RollupBucket& b, time_t t) { return b.start < t; });
+        if (it == buckets.end() || it->start != start) {
+            RollupBucket bucket;
+            bucket.start = start;
+            it = buckets.insert(it, bucket);
+        }
+        return *it;
+    }
+
+    // Whether a bucket starting at start is inside the level's retention
+    static bool retains(const Level& level, time_t start) {
+        return level.buckets.size() == level.first || start >= level.buckets.back().start - level.retention;
+    }
+
+    const RollupBucket* findBucket(const Level& level, time_t start) const {
+        auto begin = level.buckets.begin() + static_cast<std::ptrdiff_t>(level.first);
+        auto it = std::lower_bound(begin, level.buckets.end(), start,
+                                   [](const RollupBucket& b, time_t t) { return b.start < t; });
+        return it != level.buckets.end() && it->start == start ? &*it : nullptr;
+    }
+
+    void prune(Level& level) {
+        time_t horizon = level.buckets.back().start - level.retention;
+        while (level.first < level.buckets.size() && level.buckets[level.first].start < horizon) ++level.first;
+        // Compact once the dead prefix dominates, so erase stays amortized O(1)
+        if (level.first > 1024 && level.first * 2 > level.buckets.size()) {
+            level.buckets.erase(level.buckets.begin(), level.buckets.begin() + static_cast<std::ptrdiff_t>(level.first));
+            level.first = 0;
+        }
+    }
+
+    // Add (or with sign -1 remove) the energy of the linear power segment (t0, p0) -> (t1, p1)
+    void integrate(time_t t0, double p0, time_t t1, double p1, double sign = 1.0) {
+        const double slope = (p1 - p0) / static_cast<double>(t1 - t0);
+        for (auto& level : levels) {
+            time_t a = t0;
+            while (a < t1) {
+                time_t bucket_start = alignDown(a, level.resolution);
+                time_t b = std::min(t1, bucket_start + level.resolution);
+                double pa = p0 + slope * static_cast<double>(a - t0);
+                double pb = p0 + slope * static_cast<double>(b - t0);
+                if (retains(level, bucket_start)) {
+                    bucketAt(level, bucket_start).energy_wh += sign * static_cast<double>(b - a) * (pa + pb) / 2.0 / 3600.0;
+                }
+                a = b;
+            }
+        }
+    }
+
+public:
+    RollupStore(time_t minute_retention = 30 * 86400, time_t hour_retention = 2 * 365 * 86400,
+                time_t day_retention = std::numeric_limits<time_t>::max() / 2)
+        : levels{Level{RESOLUTIONS[0], minute_retention, {}},
+                 Level{RESOLUTIONS[1], hour_retention, {}},
+                 Level{RESOLUTIONS[2], day_retention, {}}} {}
+
+    // Levels whose retention a late reading predates don't get it
+    void add(const SolarReading& reading) {
+        for (auto& level : levels) {
+            time_t start = alignDown(reading.timestamp, level.resolution);
+            if (retains(level, start)) bucketAt(level, start).add(reading);
+        }
+
+        if (has_last && reading.timestamp < last_timestamp) return; // late: statistics only
+        if (has_last && reading.timestamp > last_timestamp &&
+            reading.timestamp - last_timestamp <= MAX_SAMPLE_GAP) {
+            integrate(last_timestamp, last_power, reading.timestamp, reading.power_produced);
+        }
+        last_timestamp = reading.timestamp;
+        last_power = reading.power_produced;
+        has_last = true;
+    }
+
+    void add(std::span<const SolarReading> readings) {
+        for (const auto& reading : readings) add(reading);
+    }
+
+    // A late reading whose neighbours in the stream are known: besides its
+    // bucket statistics, the energy of prev -> next is re-split through it.
+    // Levels whose retention it predates don't get it.
+    void addLate(const SolarReading& reading, const std::optional<PowerSample>& prev,
+                 const std::optional<PowerSample>& next) {
+        for (auto& level : levels) {
+            time_t start = alignDown(reading.timestamp, level.resolution);
+            if (retains(level, start)) bucketAt(level, start).add(reading);
+        }
+        const PowerSample late{reading.timestamp, reading.power_produced};
+        auto segment = [&](PowerSample a, PowerSample b, double sign) {
+            if (b.timestamp > a.timestamp && b.timestamp - a.timestamp <= MAX_SAMPLE_GAP) {
+                integrate(a.timestamp, a.watts, b.timestamp, b.watts, sign);
+            }
+        };
+        if (prev) segment(*prev, late, 1.0);
+        if (next) segment(late, *next, 1.0);
+        if (prev && next) segment(*prev, *next, -1.0);
+    }
+
+    time_t resolution(size_t level) const { return levels[level].resolution; }
+
+    std::span<const RollupBucket> buckets(size_t level) const {
+        const Level& l = levels[level];
+        return std::span<const RollupBucket>(l.buckets.data() + l.first, l.buckets.size() - l.first);
+    }
+
+    // Buckets overlapping [start, end) at the coarsest resolution whose buckets
+    // line up with both ends and give at least min_buckets points; falls back
+    // to 1-minute buckets when no resolution lines up. A level that no longer
+    // retains start gives way to the next coarser one that does.
+    RollupRange query(time_t start, time_t end, size_t min_buckets = 1) const {
+        if (start >= end) return {};
+        size_t chosen = 0;
+        for (size_t i = LEVELS; i-- > 0;) {
+            time_t res = levels[i].resolution;
+            if (start % res == 0 && end % res == 0 && static_cast<size_t>((end - start) / res) >= min_buckets) {
+                chosen = i;
+                break;
+            }
+        }
+        while (chosen + 1 < LEVELS && !retains(levels[chosen], alignDown(start, levels[chosen].resolution))) ++chosen;
+        auto all = buckets(chosen);
+        time_t first_start = alignDown(start, levels[chosen].resolution);
+        auto lo = std::lower_bound(all.begin(), all.end(), first_start,
+                                   [](const RollupBucket& b, time_t t) { return b.start < t; });
+        auto hi = std::lower_bound(lo, all.end(), end, [](const RollupBucket& b, time_t t) { return b.start < t; });
+        return RollupRange{levels[chosen].resolution, all.subspan(static_cast<size_t>(lo - all.begin()),
+                                                                  static_cast<size_t>(hi - lo))};
+    }
+
+    void save(CheckpointWriter& out) const {
+        for (size_t i = 0; i < LEVELS; ++i) {
+            out.put(levels[i].retention);
+            out.putVector(buckets(i));
+        }
+        out.put(last_timestamp);
+        out.put(last_power);
+        out.put(has_last);
+    }
+
+    void load(CheckpointReader& in) {
+        for (auto& level : levels) {
+            level.retention = in.get<time_t>();
+            in.getVector(level.buckets);
+            level.first = 0;
+            level.changed_from = std::numeric_limits<time_t>::min();
+        }
+        last_timestamp = in.get<time_t>();
+        last_power = in.get<double>();
+        has_last = in.get<bool>();
+    }
+
+    struct Changes {
+        std::array<time_t, LEVELS> retention;
+        std::array<TailChanges<RollupBucket>, LEVELS> levels;
+        time_t last_timestamp;
+        double last_power;
+        bool has_last;
+    };
+
+    // Buckets written since the previous call (all of them the first time);
+    // a store given every Changes in order by applyChanges() saves the same bytes
+    Changes takeChanges() {
+        Changes changes{};
+        for (size_t i = 0; i < LEVELS; ++i) {
+            auto live = buckets(i);
+            changes.retention[i] = levels[i].retention;
+            changes.levels[i] = TailChanges<RollupBucket>::take(live.begin(), live.end(), levels[i].changed_from,
+                                                                [](const RollupBucket& b) { return b.start; });
+        }
+        changes.last_timestamp = last_timestamp;
+        changes.last_power = last_power;
+        changes.has_last = has_last;
+        return changes;
+    }
+
+    void applyChanges(Changes&& changes) {
+        for (size_t i = 0; i < LEVELS; ++i) {
+            Level& level = levels[i];
+            level.buckets.erase(level.buckets.begin(), level.buckets.begin() + static_cast<std::ptrdiff_t>(level.first));
+            level.first = 0;
+            level.retention = changes.retention[i];
+            std::move(changes.levels[i]).applyTo(level.buckets, [](const RollupBucket& b) { return b.start; });
+        }
+        last_timestamp = changes.last_timestamp;
+        last_power = changes.last_power;
+        has_last = changes.has_last;
+    }
+
+    // Single aggregate over [start, end) (rounded out to whole minutes), built
+    // from the fewest buckets: whole days in the middle, hours and minutes at the edges
+    RollupBucket aggregate(time_t start, time_t end) const {
+        RollupBucket total;
+        total.start = start;
+        time_t t = alignDown(start, levels[0].resolution);
+        while (t < end) {
+            size_t level = 0;
+            for (size_t i = LEVELS; i-- > 1;) {
+                time_t res = levels[i].resolution;
+                if (t % res == 0 && t + res <= end) {
+                    level = i;
+                    break;
+                }
+            }
+            if (const RollupBucket* bucket = findBucket(levels[level], t)) total.merge(*bucket);
+            t += levels[level].resolution;
+        }
+        return total;
+    }
+};
+
+// Merging t-digest (Dunning & Ertl): a mergeable quantile sketch of at most
+// about `compression` centroids. The k1 scale function keeps centroids small
+// near both tails, so p5 and p95 stay accurate to a fraction of a percent
+// of rank. Samples and merged sketches are buffered and folded in batches.
+class TDigest {
+public:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+private:
+    // Queries fold the pending buffer in first, hence mutable
+    mutable std::vector<Centroid> centroids; // sorted by mean
+    mutable std::vector<Centroid> pending;
+    mutable double total = 0.0;              // weight in centroids
+    double compression;
+    double min_value = std::numeric_limits<double>::infinity();
+    double max_value = -std::numeric_limits<double>::infinity();
+
+    size_t bufferLimit() const { return static_cast<size_t>(4 * compression); }
+
+    // Rank (as a fraction) at which the k1 scale k(q) = δ/2π·asin(2q - 1)
+    // has grown by one from q
+    double nextLimit(double q) const {
+        const double k = compression / (2.0 * M_PI) * std::asin(2.0 * q - 1.0) + 1.0;
+        if (k >= compression / 4.0) return 1.0;
+        return (std::sin(k * 2.0 * M_PI / compression) + 1.0) / 2.0;
+    }
+
+    void flush() const {
+        if (pending.empty()) return;
+        pending.insert(pending.end(), centroids.begin(), centroids.end());
+        std::sort(pending.begin(), pending.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+        double weight = 0.0;
+        for (const auto& c : pending) weight += c.weight;
+
+        centroids.clear();
+        Centroid current = pending.front();
+        double before = 0.0;
+        double limit = weight * nextLimit(0.0);
+        for (size_t i = 1; i < pending.size(); ++i) {
+            const Centroid& next = pending[i];
+            if (before + current.weight + next.weight <= limit) {
+                current.weight += next.weight;
+                current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            } else {
+                before += current.weight;
+                centroids.push_back(current);
+                limit = weight * nextLimit(before / weight);
+                current = next;
+            }
+        }
+        centroids.push_back(current);
+        total = weight;
+        pending.clear();
+    }
+
+public:
+    TDigest() : TDigest(SKETCH_COMPRESSION) {}
+    explicit TDigest(double delta) : compression(delta) {}
+
+    void add(double value, double weight = 1.0) {
+        if (!std::isfinite(value)) return;
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+        pending.push_back({value, weight});
+        if (pending.size() >= bufferLimit()) flush();
+    }
+
+    void merge(const TDigest& other) {
+        other.flush();
+        if (other.centroids.empty()) return;
+        min_value = std::min(min_value, other.min_value);
+        max_value = std::max(max_value, other.max_value);
+        pending.insert(pending.end(), other.centroids.begin(), other.centroids.end());
+        if (pending.size() >= bufferLimit()) flush();
+    }
+
+    // Fold the buffer in and release spare capacity, for sketches that are done growing
+    void compact() {
+        flush();
+        pending.shrink_to_fit();
+        centroids.shrink_to_fit();
+    }
+
+    double count() const {
+        flush();
+        return total;
+    }
+
+    // Value at rank q in [0, 1], interpolated between centroid centres (and
+    // from the outer centres to the exact min and max); NaN when empty
+    double quantile(double q) const {
+        flush();
+        if (centroids.empty()) return std::nan("");
+        const double index = std::clamp(q, 0.0, 1.0) * total;
+        const Centroid& first = centroids.front();
+        const Centroid& last = centroids.back();
+        if (index < first.weight / 2.0) {
+            return min_value + (first.mean - min_value) * index / (first.weight / 2.0);
+        }
+        if (index > total - last.weight / 2.0) {
+            return last.mean + (max_value - last.mean) * (index - (total - last.weight / 2.0)) / (last.weight / 2.0);
+        }
+        double centre = first.weight / 2.0; // rank of centroid i's centre
+        for (size_t i = 0; i + 1 < centroids.size(); ++i) {
+            const double gap = (centroids[i].weight + centroids[i + 1].weight) / 2.0;
+            if (index <= centre + gap) {
+                return centroids[i].mean + (centroids[i + 1].mean - centroids[i].mean) * (index - centre) / gap;
+            }
+            centre += gap;
+        }
+        return last.mean;
+    }
+
+    size_t memoryBytes() const { return (centroids.capacity() + pending.capacity()) * sizeof(Centroid); }
+
+    // The buffer is saved as is: folding it in early would change later
+    // results, and a restore reproduces the sketch exactly
+    void save(CheckpointWriter& out) const {
+        out.put(compression);
+        out.put(min_value);
+        out.put(max_value);
+        out.putVector<Centroid>(centroids);
+        out.putVector<Centroid>(pending);
+    }
+
+    void load(CheckpointReader& in) {
+        compression = in.get<double>();
+        min_value = in.get<double>();
+        max_value = in.get<double>();
+        in.getVector(centroids);
+        in.getVector(pending);
+        total = 0.0;
+        for (const auto& c : centroids) total += c.weight;
+        if (!(compression >= 1.0)) throw std::runtime_error("Corrupt checkpoint sketch");
+    }
+};
+
+// Quantile sketches of one window: panel efficiency (only at irradiance
+// where it's meaningful, as for the efficiency check) and temperature
+struct QuantileSketches {
+    TDigest efficiency;
+    TDigest temperature;
+
+    void add(const SolarReading& reading, double panel_efficiency) {
+        if (reading.irradiance >= EfficiencyTracker::MIN_IRRADIANCE) efficiency.add(panel_efficiency);
+        temperature.add(reading.temperature);
+    }
+
+    void merge(const QuantileSketches& other) {
+        efficiency.merge(other.efficiency);
+        temperature.merge(other.temperature);
+    }
+
+    void compact() {
+        efficiency.compact();
+        temperature.compact();
+    }
+};
+
+// Hourly and daily quantile sketches of one source. Memory is bounded by the
+// levels' retention, whatever the reading rate or history length; sketches
+// don't depend on arrival order, so late readings simply join their bucket.
+// Time ranges are half-open: [start, end).
+class QuantileStore {
+    static constexpr time_t HOUR = 3600;
+    static constexpr time_t DAY = 86400;
+
+    struct Bucket {
+        time_t start;
+        QuantileSketches sketches;
+    };
+
+    struct Level {
+        time_t resolution;
+        time_t retention;
+        std::deque<Bucket> buckets;
+        // Queries fold sketch buffers in too, hence mutable; see takeChanges()
+        mutable time_t changed_from = std::numeric_limits<time_t>::min();
+    };
+
+    Level hours;
+    Level days;
+
+    static time_t alignDown(time_t t, time_t resolution) { return floorDiv(t, resolution) * resolution; }
+
+    // Bucket for start, or null if it predates the level's retention
+    static QuantileSketches* bucketAt(Level& level, time_t start) {
+        auto& buckets = level.buckets;
+        if (buckets.empty() || buckets.back().start < start) {
+            if (!buckets.empty()) {
+                level.changed_from = std::min(level.changed_from, buckets.back().start);
+                buckets.back().sketches.compact();
+            }
+            level.changed_from = std::min(level.changed_from, start);
+            buckets.push_back(Bucket{start, {}});
+            while (buckets.front().start < start - level.retention) buckets.pop_front();
+            return &buckets.back().sketches;
+        }
+        if (start < buckets.back().start - level.retention) return nullptr;
+        level.changed_from = std::min(level.changed_from, start);
+        auto it = std::lower_bound(buckets.begin(), buckets.end(), start,
+                                   [](const Bucket& b, time_t t) { return b.start < t; });
+        if (it == buckets.end() || it->start != start) it = buckets.insert(it, Bucket{start, {}});
+        return &it->sketches;
+    }
+
+    static void mergeRange(const Level& level, time_t start, time_t end, QuantileSketches& out) {
+        auto it = std::lower_bound(level.buckets.begin(), level.buckets.end(), start,
+                                   [](const Bucket& b, time_t t) { return b.start < t; });
+        if (it != level.buckets.end() && it->start < end) level.changed_from = std::min(level.changed_from, it->start);
+        for (; it != level.buckets.end() && it->start < end; ++it) out.merge(it->sketches);
+    }
+
+public:
+    QuantileStore(time_t hour_retention = 7 * DAY, time_t day_retention = 400 * DAY)
+        : hours{HOUR, hour_retention, {}}, days{DAY, day_retention, {}} {}
+
+    void add(const SolarReading& reading, double panel_efficiency) {
+        if (auto* hour = bucketAt(hours, alignDown(reading.timestamp, HOUR))) hour->add(reading, panel_efficiency);
+        if (auto* day = bucketAt(days, alignDown(reading.timestamp, DAY))) day->add(reading, panel_efficiency);
+    }
+
+    // Sketches covering [start, end): whole days from the daily sketches and
+    // the partial days at either end from the hourly ones (to whole hours),
+    // or from the whole day once its hours are past retention
+    QuantileSketches query(time_t start, time_t end) const {
+        QuantileSketches total;
+        if (days.buckets.empty()) return total;
+        start = std::max(start, days.buckets.front().start);
+        end = std::min(end, days.buckets.back().start + DAY);
+        const time_t hour_horizon = hours.buckets.empty() ? 0 : hours.buckets.front().start;
+        for (time_t day = alignDown(start, DAY); day < end; day += DAY) {
+            const bool whole_day = day >= start && day + DAY <= end;
+            if (whole_day || day < hour_horizon) {
+                mergeRange(days, day, day + 1, total);
+            } else {
+                mergeRange(hours, std::max(day, alignDown(start, HOUR)), std::min(day + DAY, end), total);
+            }
+        }
+        return total;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const Level* level : {&hours, &days}) {
+            for (const auto& bucket : level->buckets) {
+                bytes += sizeof(Bucket) + bucket.sketches.efficiency.memoryBytes() +
+                         bucket.sketches.temperature.memoryBytes();
+            }
+        }
+        return bytes;
+    }
+
+    void save(CheckpointWriter& out) const {
+        for (const Level* level : {&hours, &days}) {
+            out.put(level->retention);
+            out.put<uint64_t>(level->buckets.size());
+            for (const auto& bucket : level->buckets) {
+                out.put(bucket.start);
+                bucket.sketches.efficiency.save(out);
+                bucket.sketches.temperature.save(out);
+            }
+        }
+    }
+
+    void load(CheckpointReader& in) {
+        for (Level* level : {&hours, &days}) {
+            level->retention = in.get<time_t>();
+            level->buckets.clear();
+            for (uint64_t n = in.get<uint64_t>(); n > 0; --n) {
+                Bucket bucket{in.get<time_t>(), {}};
+                bucket.sketches.efficiency.load(in);
+                bucket.sketches.temperature.load(in);
+                level->buckets.push_back(std::move(bucket));
+            }
+            level->changed_from = std::numeric_limits<time_t>::min();
+        }
+    }
+
+    struct Changes {
+        std::array<time_t, 2> retention;
+        std::array<TailChanges<Bucket>, 2> levels;
+    };
+
+    // Buckets written or queried since the previous call (all of them the first
+    // time); a store given every Changes in order by applyChanges() saves the same bytes
+    Changes takeChanges() {
+        Changes changes{};
+        size_t i = 0;
+        for (Level* level : {&hours, &days}) {
+            changes.retention[i] = level->retention;
+            changes.levels[i++] = TailChanges<Bucket>::take(level->buckets.begin(), level->buckets.end(),
+                                                            level->changed_from, [](const Bucket& b) { return b.start; });
+        }
+        return changes;
+    }
+
+    void applyChanges(Changes&& changes) {
+        size_t i = 0;
+        for (Level* level : {&hours, &days}) {
+            level->retention = changes.retention[i];
+            std::move(changes.levels[i++]).applyTo(level->buckets, [](const Bucket& b) { return b.start; });
+        }
+    }
+};
+
+// Time-series dashboard over a source's hourly rollups: a static page
+// (dashboard.html, written once by atomic rename) that loads an append-only
+// data script (dashboard_data.js). update() appends each hour bucket once it
+// has closed, i.e. once a reading in a later hour has arrived, as one line
+//   D.push([start,count,energy_wh,produced_mean,produced_max,consumed_mean,soc_mean,irradiance_mean,temperature_mean]);
+// All new lines go out in a single write, and a restarted writer resumes
+// after the last bucket already in the file. Late readings for a bucket
+// that was already written don't change the dashboard.
+class DashboardWriter {
+    static constexpr size_t LEVEL = 1; // hourly buckets
+
+    std::string html_path;
+    std::string data_path;
+    time_t written_through = std::numeric_limits<time_t>::min(); // start of the last bucket written
+    std::string buffer;
+
+    static constexpr const char* PAGE = R"(<!DOCTYPE html>
+<html>
+<head>
+    <title>Solar Energy Dashboard</title>
+    <meta charset="utf-8">
+    <script src="https://cdn.jsdelivr.net/npm/chart.js"></script>
+    <script>var D = [];</script>
+    <script src="dashboard_data.js"></script>
+    <style>
+        .dashboard { display: flex; flex-wrap: wrap; gap: 20px; }
+        .chart-container { width: 45%; min-width: 300px; }
+    </style>
+</head>
+<body>
+    <h1>Solar Energy Dashboard</h1>
+    <div class="dashboard">
+        <div class="chart-container"><canvas id="energy"></canvas></div>
+        <div class="chart-container"><canvas id="power"></canvas></div>
+        <div class="chart-container"><canvas id="battery"></canvas></div>
+        <div class="chart-container"><canvas id="temperature"></canvas></div>
+    </div>
+    <script>
+        // Bucket fields: [start, count, energy_wh, produced, produced_max, consumed, soc, irradiance, temperature]
+        const labels = D.map(b => new Date(b[0] * 1000).toISOString().slice(0, 13).replace('T', ' '));
+        const series = (label, i, color) => ({ label, data: D.map(b => b[i]), borderColor: color,
+                                              backgroundColor: color, pointRadius: 0, borderWidth: 1 });
+        const chart = (id, type, title, datasets) => new Chart(document.getElementById(id), {
+            type, data: { labels, datasets },
+            options: { responsive: true, animation: false,
+                       plugins: { title: { display: true, text: title } } }
+        });
+        chart('energy', 'bar', 'Energy produced per hour (Wh)', [series('Energy', 2, '#FFA500')]);
+        chart('power', 'line', 'Mean power (W)', [series('Produced', 3, '#FFA500'),
+                                                  series('Peak produced', 4, '#FFD280'),
+                                                  series('Consumed', 5, '#4B8BC0')]);
+        chart('battery', 'line', 'Battery state of charge (%)', [series('SOC', 6, '#4BC0C0')]);
+        chart('temperature', 'line', 'Irradiance (W/m²) and temperature (°C)',
+              [series('Irradiance', 7, '#FFCD56'), series('Temperature', 8, '#FF6384')]);
+    </script>
+</body>
+</html>
+)";
+
+    void appendNumber(double value) {
+        char text[32];
+        if (!std::isfinite(value)) value = 0.0;
+        auto [end, err] = std::to_chars(text, text + sizeof(text), value);
+        buffer.append(text, end);
+    }
+
+    void appendBucket(const RollupBucket& bucket) {
+        buffer += "D.push([";
+        appendNumber(static_cast<double>(bucket.start));
+        buffer += ',';
+        appendNumber(static_cast<double>(bucket.count));
+        for (double value : {bucket.energy_wh, bucket.mean(bucket.power_produced), bucket.power_produced.max,
+                             bucket.mean(bucket.power_consumed), bucket.mean(bucket.battery_soc),
+                             bucket.mean(bucket.irradiance), bucket.mean(bucket.temperature)}) {
+            buffer += ',';
+            appendNumber(value);
+        }
+        buffer += "]);\n";
+    }
+
+    // Start of the last bucket in an existing data file, read from its tail
+    void resume() {
+        int fd = ::open(data_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        char tail[4096];
+        off_t size = ::lseek(fd, 0, SEEK_END);
+        off_t from = std::max<off_t>(0, size - static_cast<off_t>(sizeof(tail)));
+        ssize_t n = ::pread(fd, tail, sizeof(tail), from);
+        ::close(fd);
+        if (n <= 0) return;
+        std::string_view text(tail, static_cast<size_t>(n));
+        auto pos = text.rfind("D.push([");
+        if (pos == std::string_view::npos) return;
+        const char* p = text.data() + pos + 8;
+        int64_t start = 0;
+        if (std::from_chars(p, text.data() + text.size(), start).ec == std::errc()) {
+            written_through = static_cast<time_t>(start);
+        }
+    }
+
+public:
+    explicit DashboardWriter(const std::string& directory)
+        : html_path(directory + "/dashboard.html"), data_path(directory + "/dashboard_data.js") {
+        if (!writeFileAtomically(html_path, PAGE)) {
+            throw std::runtime_error("Cannot write " + html_path + ": " + std::strerror(errno));
+        }
+        resume();
+    }
+
+    // Append the buckets that closed since the last call; returns how many
+    size_t update(const RollupStore& rollups) {
+        auto buckets = rollups.buckets(LEVEL);
+        if (buckets.size() < 2) return 0;
+        auto first = std::upper_bound(buckets.begin(), buckets.end() - 1, written_through,
+                                      [](time_t t, const RollupBucket& b) { return t < b.start; });
+        const size_t closed = static_cast<size_t>(buckets.end() - 1 - first);
+        if (closed == 0) return 0;
+
+        buffer.clear();
+        for (auto it = first; it != buckets.end() - 1; ++it) appendBucket(*it);
+
+        int fd = ::open(data_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot open " + data_path + ": " + std::strerror(errno));
+        const char* p = buffer.data();
+        size_t left = buffer.size();
+        while (left > 0) {
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("Cannot append to " + data_path + ": " + std::strerror(error));
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        ::close(fd);
+        written_through = (buckets.end() - 2)->start;
+        return closed;
+    }
+};
+
+// Database Interface
+class Database {
+public:
+    virtual ~Database() = default;
+    virtual void storeReading(const SolarReading& reading) = 0;
+    virtual std::vector<SolarReading> getReadings(time_t start, time_t end) = 0;
+
+    // Same readings written into out (cleared first), reusing its capacity so
+    // a caller that keeps one buffer queries without allocating; returns the count
+    virtual size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) {
+        out = getReadings(start, end);
+        return out.size();
+    }
+
+    // Store a batch in one call; backends override this to avoid per-row overhead
+    virtual void storeReadings(std::span<const SolarReading> batch) {
+        for (const auto& reading : batch) storeReading(reading);
+    }
+
+    // Make everything stored so far durable; a no-op for in-memory backends
+    virtual void sync() {}
+
+    // Readings in the order they were stored, from position (an earlier
+    // storedCount()) on, written into out; returns the count. A checkpoint
+    // records the position so a restart replays exactly what came after it.
+    // Stores that don't outlive the process start empty and report nothing.
+    virtual uint64_t storedCount() const { return 0; }
+    virtual size_t getStoredSince(uint64_t position, std::vector<SolarReading>& out) {
+        (void)position;
+        out.clear();
+        return 0;
+    }
+};
+
+// Mock Database implementation
+class MockDB : public Database {
+    std::vector<SolarReading> readings;
+public:
+    void storeReading(const SolarReading& reading) override {
+        readings.push_back(reading);
+        Logger::instance().log(LogLevel::Info, LogEvent::READING_STORED, reading.timestamp);
+    }
+
+    void storeReadings(std::span<const SolarReading> batch) override {
+        readings.insert(readings.end(), batch.begin(), batch.end());
+        for (const auto& reading : batch) {
+            Logger::instance().log(LogLevel::Info, LogEvent::READING_STORED, reading.timestamp);
+        }
+    }
+    
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        out.clear();
+        for (const auto& reading : readings) {
+            if (reading.timestamp >= start && reading.timestamp <= end) {
+                out.push_back(reading);
+            }
+        }
+        return out.size();
+    }
+
+    uint64_t storedCount() const override { return readings.size(); }
+
+    size_t getStoredSince(uint64_t position, std::vector<SolarReading>& out) override {
+        out.assign(readings.begin() + std::min<uint64_t>(position, readings.size()), readings.end());
+        return out.size();
+    }
+};
+
+// Zero-copy view over a time-sorted range of a ColumnarDB.
+// The spans are invalidated by the next write to the store.
+struct ReadingsView {
+    std::span<const time_t> timestamp;
+    std::span<const double> power_produced;
+    std::span<const double> power_consumed;
+    std::span<const double> battery_soc;
+    std::span<const double> irradiance;
+    std::span<const double> temperature;
+    std::span<const double> panel_voltage;
+    std::span<const double> panel_current;
+
+    size_t size() const { return timestamp.size(); }
+    bool empty() const { return timestamp.empty(); }
+
+    SolarReading operator[](size_t i) const {
+        return SolarReading(timestamp[i], power_produced[i], power_consumed[i],
+                            battery_soc[i], irradiance[i], temperature[i],
+                            panel_voltage[i], panel_current[i]);
+    }
+};
+
+// Column-oriented store: one array per field, kept sorted by timestamp
+// so range queries are two binary searches instead of a full scan.
+class ColumnarDB : public Database {
+    std::vector<time_t> timestamps;
+    std::vector<double> power_produced;
+    std::vector<double> power_consumed;
+    std::vector<double> battery_soc;
+    std::vector<double> irradiance;
+    std::vector<double> temperature;
+    std::vector<double> panel_voltage;
+    std::vector<double> panel_current;
+
+    void insertAt(size_t pos, const SolarReading& reading) {
+        timestamps.insert(timestamps.begin() + pos, reading.timestamp);
+        power_produced.insert(power_produced.begin() + pos, reading.power_produced);
+        power_consumed.insert(power_consumed.begin() + pos, reading.power_consumed);
+        battery_soc.insert(battery_soc.begin() + pos, reading.battery_soc);
+        irradiance.insert(irradiance.begin() + pos, reading.irradiance);
+        temperature.insert(temperature.begin() + pos, reading.temperature);
+        panel_voltage.insert(panel_voltage.begin() + pos, reading.panel_voltage);
+        panel_current.insert(panel_current.begin() + pos, reading.panel_current);
+    }
+
+    void append(const SolarReading& reading) {
+        timestamps.push_back(reading.timestamp);
+        power_produced.push_back(reading.power_produced);
+        power_consumed.push_back(reading.power_consumed);
+        battery_soc.push_back(reading.battery_soc);
+        irradiance.push_back(reading.irradiance);
+        temperature.push_back(reading.temperature);
+        panel_voltage.push_back(reading.panel_voltage);
+        panel_current.push_back(reading.panel_current);
+    }
+
+    // Rebuild the tail of one column from a merge order where values >= 0 are
+    // existing rows and values < 0 are batch rows encoded as -(i + 1)
+    template <typename T, typename Field>
+    static void mergeColumn(std::vector<T>& column, size_t first, const std::vector<int64_t>& order,
+                            std::span<const SolarReading> batch, Field field) {
+        std::vector<T> tail;
+        tail.reserve(order.size());
+        for (int64_t source : order) {
+            tail.push_back(source >= 0 ? column[static_cast<size_t>(source)]
+                                       : batch[static_cast<size_t>(-source - 1)].*field);
+        }
+        column.resize(first);
+        column.insert(column.end(), tail.begin(), tail.end());
+    }
+
+    // Same ordering as inserting each row at its upper_bound, but touches only the
+    // part of the store at or after the batch's oldest timestamp
+    void mergeBatch(std::span<const SolarReading> batch) {
+        std::vector<size_t> sorted(batch.size());
+        std::iota(sorted.begin(), sorted.end(), size_t{0});
+        std::stable_sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) {
+            return batch[a].timestamp < batch[b].timestamp;
+        });
+
+        size_t first = static_cast<size_t>(
+            std::upper_bound(timestamps.begin(), timestamps.end(), batch[sorted.front()].timestamp) -
+            timestamps.begin());
+
+        std::vector<int64_t> order;
+        order.reserve(timestamps.size() - first + batch.size());
+        size_t existing = first;
+        for (size_t index : sorted) {
+            while (existing < timestamps.size() && timestamps[existing] <= batch[index].timestamp) {
+                order.push_back(static_cast<int64_t>(existing++));
+            }
+            order.push_back(-static_cast<int64_t>(index) - 1);
+        }
+        while (existing < timestamps.size()) order.push_back(static_cast<int64_t>(existing++));
+
+        mergeColumn(timestamps, first, order, batch, &SolarReading::timestamp);
+        mergeColumn(power_produced, first, order, batch, &SolarReading::power_produced);
+        mergeColumn(power_consumed, first, order, batch, &SolarReading::power_consumed);
+        mergeColumn(battery_soc, first, order, batch, &SolarReading::battery_soc);
+        mergeColumn(irradiance, first, order, batch, &SolarReading::irradiance);
+        mergeColumn(temperature, first, order, batch, &SolarReading::temperature);
+        mergeColumn(panel_voltage, first, order, batch, &SolarReading::panel_voltage);
+        mergeColumn(panel_current, first, order, batch, &SolarReading::panel_current);
+    }
+
+    template <typename T>
+    static std::span<const T> slice(const std::vector<T>& column, size_t first, size_t last) {
+        return std::span<const T>(column.data() + first, last - first);
+    }
+
+public:
+    void storeReading(const SolarReading& reading) override {
+        // Readings normally arrive in time order, so this is an append
+        if (timestamps.empty() || reading.timestamp >= timestamps.back()) {
+            append(reading);
+            return;
+        }
+        auto pos = std::upper_bound(timestamps.begin(), timestamps.end(), reading.timestamp);
+        insertAt(static_cast<size_t>(pos - timestamps.begin()), reading);
+    }
+
+    void storeReadings(std::span<const SolarReading> batch) override {
+        if (batch.empty()) return;
+        bool in_order = timestamps.empty() || batch.front().timestamp >= timestamps.back();
+        for (size_t i = 1; in_order && i < batch.size(); ++i) {
+            in_order = batch[i].timestamp >= batch[i - 1].timestamp;
+        }
+        if (!in_order) {
+            mergeBatch(batch);
+            return;
+        }
+        reserve(timestamps.size() + batch.size());
+        for (const auto& reading : batch) append(reading);
+    }
+
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        ReadingsView view = viewReadings(start, end);
+        out.clear();
+        out.reserve(view.size());
+        for (size_t i = 0; i < view.size(); ++i) {
+            out.push_back(view[i]);
+        }
+        return out.size();
+    }
+
+    ReadingsView viewReadings(time_t start, time_t end) const {
+        if (start > end) return {};
+        size_t first = static_cast<size_t>(
+            std::lower_bound(timestamps.begin(), timestamps.end(), start) - timestamps.begin());
+        size_t last = static_cast<size_t>(
+            std::upper_bound(timestamps.begin() + first, timestamps.end(), end) - timestamps.begin());
+
+        ReadingsView view;
+        view.timestamp = slice(timestamps, first, last);
+        view.power_produced = slice(power_produced, first, last);
+        view.power_consumed = slice(power_consumed, first, last);
+        view.battery_soc = slice(battery_soc, first, last);
+        view.irradiance = slice(irradiance, first, last);
+        view.temperature = slice(temperature, first, last);
+        view.panel_voltage = slice(panel_voltage, first, last);
+        view.panel_current = slice(panel_current, first, last);
+        return view;
+    }
+
+    size_t size() const { return timestamps.size(); }
+
+    void reserve(size_t n) {
+        timestamps.reserve(n);
+        power_produced.reserve(n);
+        power_consumed.reserve(n);
+        battery_soc.reserve(n);
+        irradiance.reserve(n);
+        temperature.reserve(n);
+        panel_voltage.reserve(n);
+        panel_current.reserve(n);
+    }
+};
+
+// Fixed-width binary telemetry record (native byte order, 64 bytes)
+struct TelemetryRecord {
+    int64_t timestamp;
+    double power_produced;
+    double power_consumed;
+    double battery_soc;
+    double irradiance;
+    double temperature;
+    double panel_voltage;
+    double panel_current;
+};
+static_assert(sizeof(TelemetryRecord) == 64, "TelemetryRecord must stay 64 bytes");
+
+inline TelemetryRecord toRecord(const SolarReading& reading) {
+    return TelemetryRecord{static_cast<int64_t>(reading.timestamp), reading.power_produced,
+                           reading.power_consumed, reading.battery_soc, reading.irradiance,
+                           reading.temperature, reading.panel_voltage, reading.panel_current};
+}
+
+inline SolarReading fromRecord(const TelemetryRecord& record) {
+    return SolarReading(static_cast<time_t>(record.timestamp), record.power_produced,
+                        record.power_consumed, record.battery_soc, record.irradiance,
+                        record.temperature, record.panel_voltage, record.panel_current);
+}
+
+// Durable backend: an append-only file of TelemetryRecords behind a small
+// header, memory-mapped for reads. A sparse index holding every
+// INDEX_STRIDE-th timestamp lets range queries seek straight to the first
+// block of interest. Opening an existing log maps it and samples the index
+// without reading every record; out-of-order appends are flagged in the
+// header and make queries fall back to a scan.
+class MappedLogDB : public Database {
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t unsorted;
+        char reserved[44];
+    };
+    static_assert(sizeof(Header) == 64, "Header must stay 64 bytes");
+
+    static constexpr const char MAGIC[8] = {'S', 'O', 'L', 'A', 'R', 'L', 'O', 'G'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t INDEX_STRIDE = 1024;
+    static constexpr size_t WRITE_BUFFER_RECORDS = 4096;
+
+    int fd = -1;
+    std::string path;
+    Header header{};
+    size_t record_count = 0;           // records on disk
+    const TelemetryRecord* mapped = nullptr;
+    size_t mapped_records = 0;
+    size_t mapped_bytes = 0;
+    std::vector<time_t> sparse_index;  // timestamp of record i * INDEX_STRIDE
+    std::vector<TelemetryRecord> pending;
+    time_t last_timestamp = 0;
+
+    static std::runtime_error ioError(const std::string& what, const std::string& file) {
+        return std::runtime_error(what + " " + file + ": " + std::strerror(errno));
+    }
+
+    void writeAll(const void* data, size_t bytes, off_t offset) {
+        auto* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::pwrite(fd, p, bytes, offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw ioError("Cannot write", path);
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += n;
+        }
+    }
+
+    static off_t recordOffset(size_t index) {
+        return static_cast<off_t>(sizeof(Header) + index * sizeof(TelemetryRecord));
+    }
+
+    void unmap() {
+        if (mapped) ::munmap(const_cast<TelemetryRecord*>(mapped), mapped_bytes);
+        mapped = nullptr;
+        mapped_records = 0;
+        mapped_bytes = 0;
+    }
+
+    // Make the mapping cover every record on disk
+    void remap() {
+        if (mapped_records == record_count) return;
+        unmap();
+        if (record_count == 0) return;
+        mapped_bytes = static_cast<size_t>(recordOffset(record_count));
+        void* p = ::mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            mapped_bytes = 0;
+            throw ioError("Cannot map", path);
+        }
+        ::madvise(p, mapped_bytes, MADV_RANDOM);
+        mapped = reinterpret_cast<const TelemetryRecord*>(static_cast<const char*>(p) + sizeof(Header));
+        mapped_records = record_count;
+    }
+
+    void markUnsorted() {
+        if (header.unsorted) return;
+        header.unsorted = 1;
+        writeAll(&header, sizeof(header), 0);
+    }
+
+    void flushPending() {
+        if (pending.empty()) return;
+        writeAll(pending.data(), pending.size() * sizeof(TelemetryRecord), recordOffset(record_count));
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if ((record_count + i) % INDEX_STRIDE == 0) {
+                sparse_index.push_back(static_cast<time_t>(pending[i].timestamp));
+            }
+        }
+        record_count += pending.size();
+        pending.clear();
+    }
+
+    void append(const SolarReading& reading) {
+        if (record_count + pending.size() > 0 && reading.timestamp < last_timestamp) markUnsorted();
+        last_timestamp = std::max(last_timestamp, reading.timestamp);
+        pending.push_back(toRecord(reading));
+    }
+
+    // Range of record indices that may hold timestamps in [start, end]
+    std::pair<size_t, size_t> candidateRange(time_t start, time_t end) const {
+        if (header.unsorted) return {0, record_count};
+        auto first_block = std::lower_bound(sparse_index.begin(), sparse_index.end(), start);
+        size_t first = first_block == sparse_index.begin()
+                           ? 0
+                           : static_cast<size_t>(first_block - sparse_index.begin() - 1) * INDEX_STRIDE;
+        auto last_block = std::upper_bound(sparse_index.begin(), sparse_index.end(), end);
+        size_t last = std::min(record_count,
+                               static_cast<size_t>(last_block - sparse_index.begin()) * INDEX_STRIDE);
+        return {first, std::max(first, last)};
+    }
+
+    void open() {
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) throw ioError("Cannot stat", path);
+        auto size = static_cast<size_t>(st.st_size);
+
+        if (size < sizeof(Header)) {
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.record_size = sizeof(TelemetryRecord);
+            writeAll(&header, sizeof(header), 0);
+        } else {
+            if (::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                header.record_size != sizeof(TelemetryRecord)) {
+                throw std::runtime_error("Not a reading log: " + path);
+            }
+            if (header.version != VERSION) throw std::runtime_error("Unsupported reading log version: " + path);
+            // Ignore a torn record left by a crash mid-append
+            record_count = (size - sizeof(Header)) / sizeof(TelemetryRecord);
+        }
+
+        remap();
+        sparse_index.reserve(record_count / INDEX_STRIDE + 1);
+        for (size_t i = 0; i < record_count; i += INDEX_STRIDE) {
+            sparse_index.push_back(static_cast<time_t>(mapped[i].timestamp));
+        }
+        if (record_count > 0) {
+            last_timestamp = header.unsorted ? std::numeric_limits<time_t>::max()
+                                             : static_cast<time_t>(mapped[record_count - 1].timestamp);
+        }
+        pending.reserve(WRITE_BUFFER_RECORDS);
+    }
+
+public:
+    explicit MappedLogDB(const std::string& file) : path(file) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) throw ioError("Cannot open", path);
+        // The destructor doesn't run for a half-built object
+        try {
+            open();
+        } catch (...) {
+            unmap();
+            ::close(fd);
+            throw;
+        }
+    }
+
+    ~MappedLogDB() override {
+        try {
+            flushPending();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+        unmap();
+        if (fd >= 0) ::close(fd);
+    }
+
+    MappedLogDB(const MappedLogDB&) = delete;
+    MappedLogDB& operator=(const MappedLogDB&) = delete;
+
+    void storeReading(const SolarReading& reading) override {
+        append(reading);
+        if (pending.size() >= WRITE_BUFFER_RECORDS) flushPending();
+    }
+
+    void storeReadings(std::span<const SolarReading> batch) override {
+        for (const auto& reading : batch) append(reading);
+        flushPending();
+    }
+
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        flushPending();
+        remap();
+        out.clear();
+        if (start > end) return 0;
+
+        auto [first, last] = candidateRange(start, end);
+        if (!header.unsorted) {
+            const TelemetryRecord* begin = std::lower_bound(
+                mapped + first, mapped + last, start,
+                [](const TelemetryRecord& record, time_t ts) { return record.timestamp < ts; });
+            first = static_cast<size_t>(begin - mapped);
+        }
+        for (size_t i = first; i < last; ++i) {
+            const TelemetryRecord& record = mapped[i];
+            if (record.timestamp > end) {
+                if (!header.unsorted) break;
+                continue;
+            }
+            if (record.timestamp >= start) out.push_back(fromRecord(record));
+        }
+        return out.size();
+    }
+
+    // Flush buffered appends and make everything written so far durable
+    void sync() override {
+        flushPending();
+        if (::fdatasync(fd) != 0) throw ioError("Cannot sync", path);
+    }
+
+    uint64_t storedCount() const override { return size(); }
+
+    // Records are appended in arrival order, so a position is a record index
+    size_t getStoredSince(uint64_t position, std::vector<SolarReading>& out) override {
+        flushPending();
+        remap();
+        out.clear();
+        for (size_t i = position; i < record_count; ++i) out.push_back(fromRecord(mapped[i]));
+        return out.size();
+    }
+
+    size_t size() const { return record_count + pending.size(); }
+};
+
+// Quantized 24-byte form of a reading, stored in blocks that carry the full
+// timestamp base. Resolutions: power 0.01 W (±21 MW), SOC 0.01 %, irradiance
+// 0.1 W/m², temperature 0.01 °C (±327 °C), voltage 0.025 V (to 1638 V),
+// current 1 mA (to 65 A). Values outside a field's range saturate and set the
+// field's bit in `saturated` so callers can tell clipped data from real data.
+struct CompactRecord {
+    uint32_t offset;        // seconds after the block base
+    int32_t power_produced; // centiwatts
+    int32_t power_consumed;
+    uint16_t battery_soc;   // 0.01 %
+    uint16_t irradiance;    // 0.1 W/m²
+    int16_t temperature;    // 0.01 °C
+    uint16_t panel_voltage; // 0.025 V
+    uint16_t panel_current; // mA
+    uint16_t saturated;     // bit per field in declaration order (power_produced = bit 0)
+};
+static_assert(sizeof(CompactRecord) == 24, "CompactRecord must stay 24 bytes");
+
+namespace compact {
+
+constexpr double POWER_SCALE = 100.0;
+constexpr double SOC_SCALE = 100.0;
+constexpr double IRRADIANCE_SCALE = 10.0;
+constexpr double TEMPERATURE_SCALE = 100.0;
+constexpr double VOLTAGE_SCALE = 40.0;
+constexpr double CURRENT_SCALE = 1000.0;
+
+template <typename T>
+T quantize(double value, double scale, uint16_t& saturated, int bit) {
+    double scaled = std::nearbyint(value * scale);
+    constexpr double lo = static_cast<double>(std::numeric_limits<T>::min());
+    constexpr double hi = static_cast<double>(std::numeric_limits<T>::max());
+    if (!(scaled >= lo && scaled <= hi)) {
+        saturated |= static_cast<uint16_t>(1u << bit);
+        return scaled < lo ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max(); // NaN -> max
+    }
+    return static_cast<T>(scaled);
+}
+
+inline CompactRecord encode(const SolarReading& reading, time_t base) {
+    CompactRecord record{};
+    record.offset = static_cast<uint32_t>(reading.timestamp - base);
+    record.power_produced = quantize<int32_t>(reading.power_produced, POWER_SCALE, record.saturated, 0);
+    record.power_consumed = quantize<int32_t>(reading.power_consumed, POWER_SCALE, record.saturated, 1);
+    record.battery_soc = quantize<uint16_t>(reading.battery_soc, SOC_SCALE, record.saturated, 2);
+    record.irradiance = quantize<uint16_t>(reading.irradiance, IRRADIANCE_SCALE, record.saturated, 3);
+    record.temperature = quantize<int16_t>(reading.temperature, TEMPERATURE_SCALE, record.saturated, 4);
+    record.panel_voltage = quantize<uint16_t>(reading.panel_voltage, VOLTAGE_SCALE, record.saturated, 5);
+    record.panel_current = quantize<uint16_t>(reading.panel_current, CURRENT_SCALE, record.saturated, 6);
+    return record;
+}
+
+inline SolarReading decode(const CompactRecord& record, time_t base) {
+    return SolarReading(base + static_cast<time_t>(record.offset),
+                        record.power_produced / POWER_SCALE, record.power_consumed / POWER_SCALE,
+                        record.battery_soc / SOC_SCALE, record.irradiance / IRRADIANCE_SCALE,
+                        record.temperature / TEMPERATURE_SCALE, record.panel_voltage / VOLTAGE_SCALE,
+                        record.panel_current / CURRENT_SCALE);
+}
+
+} // namespace compact
+
+// In-memory history at 24 bytes per reading instead of 64. Readings are kept
+// time-sorted in blocks of up to BLOCK_RECORDS, each with its own timestamp
+// base, so a range query binary-searches the blocks and then one block's
+// offsets. Late readings are inserted into the block covering them; a block
+// that grows to twice the target size is split.
+class CompactDB : public Database {
+    static constexpr size_t BLOCK_RECORDS = 4096;
+
+    struct Block {
+        time_t base;
+        std::vector<CompactRecord> records;
+
+        time_t first() const { return base + static_cast<time_t>(records.front().offset); }
+        time_t last() const { return base + static_cast<time_t>(records.back().offset); }
+    };
+
+    std::vector<Block> blocks;
+    size_t record_count = 0;
+
+    static bool fitsOffset(time_t base, time_t timestamp) {
+        return timestamp >= base && timestamp - base <= static_cast<time_t>(std::numeric_limits<uint32_t>::max());
+    }
+
+    void startBlock(const SolarReading& reading) {
+        if (!blocks.empty()) blocks.back().records.shrink_to_fit(); // sealed
+        Block block{reading.timestamp, {}};
+        block.records.reserve(BLOCK_RECORDS);
+        block.records.push_back(compact::encode(reading, block.base));
+        blocks.push_back(std::move(block));
+    }
+
+    void insertLate(const SolarReading& reading) {
+        // The block whose first timestamp is the last one <= reading's; else the first block
+        auto it = std::upper_bound(blocks.begin(), blocks.end(), reading.timestamp,
+                                   [](time_t ts, const Block& b) { return ts < b.first(); });
+        Block& block = it == blocks.begin() ? blocks.front() : *std::prev(it);
+        // Only a reading older than the first block lands below its base,
+        // which then moves down to it
+        if (!fitsOffset(std::min(block.base, reading.timestamp), std::max(reading.timestamp, block.last()))) {
+            // Out of the block's offset range; a block of its own keeps the order
+            Block single{reading.timestamp, {compact::encode(reading, reading.timestamp)}};
+            blocks.insert(it, std::move(single));
+            return;
+        }
+        if (reading.timestamp < block.base) {
+            const uint32_t shift = static_cast<uint32_t>(block.base - reading.timestamp);
+            for (auto& record : block.records) record.offset += shift;
+            block.base = reading.timestamp;
+        }
+        const uint32_t offset = static_cast<uint32_t>(reading.timestamp - block.base);
+        auto pos = std::upper_bound(block.records.begin(), block.records.end(), offset,
+                                    [](uint32_t o, const CompactRecord& r) { return o < r.offset; });
+        if (block.records.size() == block.records.capacity()) {
+            // Grow sealed blocks gently; doubling would undo the compaction
+            const size_t index = static_cast<size_t>(pos - block.records.begin());
+            block.records.reserve(block.records.size() + block.records.size() / 8 + 1);
+            pos = block.records.begin() + static_cast<std::ptrdiff_t>(index);
+        }
+        block.records.insert(pos, compact::encode(reading, block.base));
+
+        if (block.records.size() >= 2 * BLOCK_RECORDS) {
+            const size_t index = static_cast<size_t>(&block - blocks.data());
+            Block tail{blocks[index].base, {}};
+            auto middle = blocks[index].records.begin() + BLOCK_RECORDS;
+            tail.records.assign(middle, blocks[index].records.end());
+            blocks[index].records.erase(middle, blocks[index].records.end());
+            blocks[index].records.shrink_to_fit();
+            blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(index) + 1, std::move(tail));
+        }
+    }
+
+public:
+    void storeReading(const SolarReading& reading) override {
+        ++record_count;
+        if (blocks.empty()) {
+            startBlock(reading);
+            return;
+        }
+        Block& tail = blocks.back();
+        if (reading.timestamp < tail.last()) {
+            insertLate(reading);
+            return;
+        }
+        // A full block or one whose offsets would overflow starts a new one
+        if (tail.records.size() >= BLOCK_RECORDS || !fitsOffset(tail.base, reading.timestamp)) {
+            startBlock(reading);
+            return;
+        }
+        tail.records.push_back(compact::encode(reading, tail.base));
+    }
+
+    // Calls f(const SolarReading&) for each reading in [start, end], in time order
+    template <typename F>
+    void forEachReading(time_t start, time_t end, F&& f) const {
+        if (start > end) return;
+        auto it = std::lower_bound(blocks.begin(), blocks.end(), start,
+                                   [](const Block& b, time_t ts) { return b.last() < ts; });
+        for (; it != blocks.end() && it->first() <= end; ++it) {
+            const Block& block = *it;
+            auto from = block.records.begin();
+            if (start > block.base) {
+                const uint32_t offset = static_cast<uint32_t>(start - block.base);
+                from = std::lower_bound(block.records.begin(), block.records.end(), offset,
+                                        [](const CompactRecord& r, uint32_t o) { return r.offset < o; });
+            }
+            for (auto record = from; record != block.records.end(); ++record) {
+                if (block.base + static_cast<time_t>(record->offset) > end) return;
+                f(compact::decode(*record, block.base));
+            }
+        }
+    }
+
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        out.clear();
+        forEachReading(start, end, [&](const SolarReading& reading) { out.push_back(reading); });
+        return out.size();
+    }
+
+    size_t size() const { return record_count; }
+
+    size_t memoryBytes() const {
+        size_t bytes = blocks.capacity() * sizeof(Block);
+        for (const auto& block : blocks) bytes += block.records.capacity() * sizeof(CompactRecord);
+        return bytes;
+    }
+};
+
+// Gorilla-style compression (Pelkonen et al., VLDB 2015) of time-sorted
+// readings into one bit stream: timestamps as delta-of-delta in variable
+// width buckets, each value field XORed with its previous value and stored
+// as the meaningful bits only. Lossless; steady cadences and slowly
+// changing fields cost a few bits per reading.
+namespace gorilla {
+
+constexpr std::array<double SolarReading::*, 7> FIELDS{
+    &SolarReading::power_produced, &SolarReading::power_consumed, &SolarReading::battery_soc,
+    &SolarReading::irradiance, &SolarReading::temperature, &SolarReading::panel_voltage,
+    &SolarReading::panel_current};
+
+// MSB-first bit appender
+class BitWriter {
+    std::vector<uint64_t>& words;
+    unsigned used = 64; // bits used in the last word
+
+public:
+    explicit BitWriter(std::vector<uint64_t>& out) : words(out) { words.clear(); }
+
+    void write(uint64_t value, unsigned bits) {
+        if (bits < 64) value &= (uint64_t{1} << bits) - 1;
+        if (used == 64) {
+            words.push_back(0);
+            used = 0;
+        }
+        const unsigned free = 64 - used;
+        if (bits <= free) {
+            words.back() |= value << (free - bits);
+            used += bits;
+        } else {
+            const unsigned rest = bits - free;
+            words.back() |= value >> rest;
+            words.push_back(value << (64 - rest));
+            used = rest;
+        }
+    }
+};
+
+class BitReader {
+    std::span<const uint64_t> words;
+    size_t position = 0;
+
+public:
+    explicit BitReader(std::span<const uint64_t> bits) : words(bits) {}
+
+    uint64_t read(unsigned bits) {
+        const size_t word = position / 64;
+        const unsigned offset = static_cast<unsigned>(position % 64);
+        position += bits;
+        uint64_t value = words[word] << offset;
+        if (offset + bits > 64) value |= words[word + 1] >> (64 - offset);
+        return bits == 64 ? value : value >> (64 - bits);
+    }
+};
+
+struct TimestampState {
+    int64_t previous = 0;
+    int64_t delta = 0;
+};
+
+// Control bits '0', '10', '110', '1110', '1111' select a delta-of-delta
+// width of 0, 7, 9, 12 or 64 bits
+inline void writeTimestamp(BitWriter& out, TimestampState& state, int64_t timestamp) {
+    const int64_t delta = timestamp - state.previous;
+    const int64_t dod = delta - state.delta;
+    state.previous = timestamp;
+    state.delta = delta;
+    if (dod == 0) {
+        out.write(0b0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        out.write(0b10, 2);
+        out.write(static_cast<uint64_t>(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        out.write(0b110, 3);
+        out.write(static_cast<uint64_t>(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        out.write(0b1110, 4);
+        out.write(static_cast<uint64_t>(dod + 2047), 12);
+    } else {
+        out.write(0b1111, 4);
+        out.write(static_cast<uint64_t>(dod), 64);
+    }
+}
+
+inline int64_t readTimestamp(BitReader& in, TimestampState& state) {
+    int64_t dod = 0;
+    if (in.read(1) == 0) {
+        dod = 0;
+    } else if (in.read(1) == 0) {
+        dod = static_cast<int64_t>(in.read(7)) - 63;
+    } else if (in.read(1) == 0) {
+        dod = static_cast<int64_t>(in.read(9)) - 255;
+    } else if (in.read(1) == 0) {
+        dod = static_cast<int64_t>(in.read(12)) - 2047;
+    } else {
+        dod = static_cast<int64_t>(in.read(64));
+    }
+    state.delta += dod;
+    state.previous += state.delta;
+    return state.previous;
+}
+
+struct ValueState {
+    uint64_t previous = 0;
+    unsigned leading = 64; // window of the last stored XOR; none yet
+    unsigned trailing = 0;
+};
+
+// '0': same as previous; '10': XOR fits the previous window; '11': 5 bits of
+// leading zeros, 6 bits of length - 1, then the meaningful bits
+inline void writeValue(BitWriter& out, ValueState& state, double value) {
+    const uint64_t bits = std::bit_cast<uint64_t>(value);
+    const uint64_t x = bits ^ state.previous;
+    state.previous = bits;
+    if (x == 0) {
+        out.write(0b0, 1);
+        return;
+    }
+    const unsigned leading = std::min(31u, static_cast<unsigned>(std::countl_zero(x)));
+    const unsigned trailing = static_cast<unsigned>(std::countr_zero(x));
+    if (state.leading <= leading && state.trailing <= trailing) {
+        out.write(0b10, 2);
+        out.write(x >> state.trailing, 64 - state.leading - state.trailing);
+        return;
+    }
+    const unsigned length = 64 - leading - trailing;
+    out.write(0b11, 2);
+    out.write(leading, 5);
+    out.write(length - 1, 6);
+    out.write(x >> trailing, length);
+    state.leading = leading;
+    state.trailing = trailing;
+}
+
+inline double readValue(BitReader& in, ValueState& state) {
+    if (in.read(1) == 0) return std::bit_cast<double>(state.previous);
+    if (in.read(1) == 1) {
+        state.leading = static_cast<unsigned>(in.read(5));
+        const unsigned length = static_cast<unsigned>(in.read(6)) + 1;
+        state.trailing = 64 - state.leading - length;
+    }
+    state.previous ^= in.read(64 - state.leading - state.trailing) << state.trailing;
+    return std::bit_cast<double>(state.previous);
+}
+
+inline void encode(std::span<const SolarReading> readings, std::vector<uint64_t>& out) {
+    BitWriter writer(out);
+    TimestampState time;
+    std::array<ValueState, FIELDS.size()> values{};
+    for (const auto& reading : readings) {
+        writeTimestamp(writer, time, static_cast<int64_t>(reading.timestamp));
+        for (size_t f = 0; f < FIELDS.size(); ++f) writeValue(writer, values[f], reading.*FIELDS[f]);
+    }
+}
+
+// Calls f(const SolarReading&) for each of the count readings in bits, in
+// order, until it returns false
+template <typename F>
+void decode(std::span<const uint64_t> bits, size_t count, F&& f) {
+    BitReader reader(bits);
+    TimestampState time;
+    std::array<ValueState, FIELDS.size()> values{};
+    SolarReading reading(0, 0, 0, 0, 0, 0, 0, 0);
+    for (size_t i = 0; i < count; ++i) {
+        reading.timestamp = static_cast<time_t>(readTimestamp(reader, time));
+        for (size_t f = 0; f < FIELDS.size(); ++f) reading.*FIELDS[f] = readValue(reader, values[f]);
+        if (!f(reading)) return;
+    }
+}
+
+} // namespace gorilla
+
+// Tiered in-memory history. Readings within hot_span of the newest stay
+// uncompressed, where the streaming side reads them; older ones are sealed
+// into Gorilla blocks of BLOCK_READINGS; blocks that fall warm_span behind
+// the newest are reduced to hourly means (the cold tier), so very old ranges
+// come back downsampled, one reading per hour stamped at the hour's start.
+// getReadings() decodes only the blocks that overlap the range. Late
+// readings go to the tier covering them; a warm block is re-encoded.
+class TieredDB : public Database {
+    static constexpr size_t BLOCK_READINGS = 1024;
+    static constexpr time_t COLD_RESOLUTION = 3600;
+
+    struct Block {
+        time_t first;
+        time_t last;
+        size_t count;
+        std::vector<uint64_t> bits;
+    };
+
+    struct ColdBucket {
+        time_t start;
+        uint64_t count;
+        std::array<double, gorilla::FIELDS.size()> sums; // in gorilla::FIELDS order
+    };
+
+    time_t hot_span;
+    time_t warm_span;
+    std::deque<SolarReading> hot; // time-sorted, like the tiers below
+    std::deque<Block> warm;
+    std::deque<ColdBucket> cold;
+    time_t newest = std::numeric_limits<time_t>::min();
+    std::vector<SolarReading> scratch;
+
+    static Block seal(std::span<const SolarReading> readings) {
+        Block block{readings.front().timestamp, readings.back().timestamp, readings.size(), {}};
+        gorilla::encode(readings, block.bits);
+        block.bits.shrink_to_fit();
+        return block;
+    }
+
+    void decodeInto(const Block& block, std::vector<SolarReading>& out) const {
+        out.clear();
+        out.reserve(block.count);
+        gorilla::decode(block.bits, block.count, [&](const SolarReading& r) {
+            out.push_back(r);
+            return true;
+        });
+    }
+
+    void addCold(const SolarReading& reading) {
+        const time_t start = floorDiv(reading.timestamp, COLD_RESOLUTION) * COLD_RESOLUTION;
+        auto it = std::lower_bound(cold.begin(), cold.end(), start,
+                                   [](const ColdBucket& b, time_t t) { return b.start < t; });
+        if (it == cold.end() || it->start != start) it = cold.insert(it, ColdBucket{start, 0, {}});
+        ++it->count;
+        for (size_t f = 0; f < gorilla::FIELDS.size(); ++f) it->sums[f] += reading.*gorilla::FIELDS[f];
+    }
+
+    void insertWarm(const SolarReading& reading) {
+        // The block whose first timestamp is the last one <= reading's; else the first block
+        auto it = std::upper_bound(warm.begin(), warm.end(), reading.timestamp,
+                                   [](time_t t, const Block& b) { return t < b.first; });
+        if (it != warm.begin()) --it;
+        decodeInto(*it, scratch);
+        auto pos = std::upper_bound(scratch.begin(), scratch.end(), reading.timestamp,
+                                    [](time_t t, const SolarReading& r) { return t < r.timestamp; });
+        scratch.insert(pos, reading);
+        if (scratch.size() < 2 * BLOCK_READINGS) {
+            *it = seal(scratch);
+            return;
+        }
+        std::span<const SolarReading> all(scratch);
+        *it = seal(all.first(BLOCK_READINGS));
+        warm.insert(it + 1, seal(all.subspan(BLOCK_READINGS)));
+    }
+
+    void insertHot(const SolarReading& reading) {
+        if (hot.empty() || reading.timestamp >= hot.back().timestamp) {
+            hot.push_back(reading);
+            return;
+        }
+        auto pos = std::upper_bound(hot.begin(), hot.end(), reading.timestamp,
+                                    [](time_t t, const SolarReading& r) { return t < r.timestamp; });
+        hot.insert(pos, reading);
+    }
+
+    // Seal full blocks that left the hot span, then archive blocks that left the warm span
+    void age() {
+        while (hot.size() >= BLOCK_READINGS && hot[BLOCK_READINGS - 1].timestamp < newest - hot_span) {
+            scratch.assign(hot.begin(), hot.begin() + BLOCK_READINGS);
+            warm.push_back(seal(scratch));
+            hot.erase(hot.begin(), hot.begin() + BLOCK_READINGS);
+        }
+        while (!warm.empty() && warm.front().last < newest - warm_span) {
+            gorilla::decode(warm.front().bits, warm.front().count, [&](const SolarReading& r) {
+                addCold(r);
+                return true;
+            });
+            warm.pop_front();
+        }
+    }
+
+public:
+    explicit TieredDB(time_t hot_seconds = 24 * 3600, time_t warm_seconds = 90 * 24 * 3600)
+        : hot_span(hot_seconds), warm_span(std::max(hot_seconds, warm_seconds)) {}
+
+    void storeReading(const SolarReading& reading) override {
+        newest = std::max(newest, reading.timestamp);
+        if (!warm.empty() && reading.timestamp <= warm.back().last) {
+            if (reading.timestamp < warm.front().first && !cold.empty()) {
+                addCold(reading);
+            } else {
+                insertWarm(reading);
+            }
+        } else if (warm.empty() && !cold.empty() && reading.timestamp < cold.back().start + COLD_RESOLUTION) {
+            addCold(reading);
+        } else {
+            insertHot(reading);
+        }
+        age();
+    }
+
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        out.clear();
+        if (start > end) return 0;
+        auto bucket = std::lower_bound(cold.begin(), cold.end(), start,
+                                       [](const ColdBucket& b, time_t t) { return b.start < t; });
+        for (; bucket != cold.end() && bucket->start <= end; ++bucket) {
+            SolarReading mean(bucket->start, 0, 0, 0, 0, 0, 0, 0);
+            for (size_t f = 0; f < gorilla::FIELDS.size(); ++f) {
+                mean.*gorilla::FIELDS[f] = bucket->sums[f] / static_cast<double>(bucket->count);
+            }
+            out.push_back(mean);
+        }
+        auto block = std::lower_bound(warm.begin(), warm.end(), start,
+                                      [](const Block& b, time_t t) { return b.last < t; });
+        for (; block != warm.end() && block->first <= end; ++block) {
+            gorilla::decode(block->bits, block->count, [&](const SolarReading& r) {
+                if (r.timestamp > end) return false;
+                if (r.timestamp >= start) out.push_back(r);
+                return true;
+            });
+        }
+        auto from = std::lower_bound(hot.begin(), hot.end(), start,
+                                     [](const SolarReading& r, time_t t) { return r.timestamp < t; });
+        for (; from != hot.end() && from->timestamp <= end; ++from) out.push_back(*from);
+        return out.size();
+    }
+
+    // Full-resolution readings held (hot and warm) and hourly buckets archived
+    size_t size() const {
+        size_t count = hot.size();
+        for (const auto& block : warm) count += block.count;
+        return count;
+    }
+    size_t coldBuckets() const { return cold.size(); }
+
+    size_t memoryBytes() const {
+        size_t bytes = hot.size() * sizeof(SolarReading) + cold.size() * sizeof(ColdBucket);
+        for (const auto& block : warm) bytes += sizeof(Block) + block.bits.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+};
+
+// Asynchronous storage: writes are accepted immediately and numbered; a write
+// is durable once durableSequence() reaches its number. flush() resolves when
+// everything submitted before it is durable.
+class AsyncDatabase {
+public:
+    virtual ~AsyncDatabase() = default;
+
+    // Queue readings for storage; returns the sequence number of the last one
+    virtual uint64_t submit(std::span<const SolarReading> batch) = 0;
+    virtual std::future<uint64_t> flush() = 0;
+    virtual uint64_t durableSequence() const = 0;
+    virtual std::future<std::vector<SolarReading>> queryReadings(time_t start, time_t end) = 0;
+};
+
+// Write-behind adapter over a synchronous backend. Callers only copy readings
+// into a pending buffer; a writer thread group-commits them with one
+// storeReadings() + sync() per batch, once MAX_BATCH readings are waiting or
+// the oldest has waited max_delay, so the maintenance checks run while the
+// previous batch is still being written. It is also a Database, so
+// SolarOptimizer can use it unchanged; reads flush first and therefore see
+// every earlier write. A backend error is rethrown to the next caller.
+class WriteBehindDB : public Database, public AsyncDatabase {
+    static constexpr size_t MAX_BATCH = 8192;
+    static constexpr size_t MAX_PENDING = 16 * MAX_BATCH; // submitters wait beyond this
+
+    std::unique_ptr<Database> backend;
+    std::chrono::steady_clock::duration max_delay;
+    uint64_t stored_base; // backend's storedCount() when it was wrapped
+
+    mutable std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable space_ready;
+    std::vector<SolarReading> pending;
+    std::chrono::steady_clock::time_point oldest_pending;
+    std::vector<std::pair<uint64_t, std::promise<uint64_t>>> waiters; // target sequence, promise
+    uint64_t submitted = 0;
+    std::atomic<uint64_t> durable{0};
+    bool flush_requested = false;
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    std::mutex backend_mutex; // serializes backend access between writer and readers
+    std::thread writer;
+
+    void rethrowFailure() const {
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    void writeLoop() {
+        std::vector<SolarReading> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            auto ready = [&] {
+                return stopping || flush_requested || pending.size() >= MAX_BATCH ||
+                       (!pending.empty() && std::chrono::steady_clock::now() >= oldest_pending + max_delay);
+            };
+            while (!ready()) {
+                if (pending.empty()) work_ready.wait(lock);
+                else work_ready.wait_until(lock, oldest_pending + max_delay);
+            }
+            if (pending.empty()) {
+                flush_requested = false;
+                completeWaiters();
+                if (stopping) return;
+                continue;
+            }
+            batch.swap(pending); // both buffers keep their capacity
+            const uint64_t through = submitted;
+            flush_requested = false;
+            space_ready.notify_all();
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                std::lock_guard<std::mutex> guard(backend_mutex);
+                backend->storeReadings(batch);
+                backend->sync();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            batch.clear();
+
+            lock.lock();
+            if (error) {
+                failure = error;
+                for (auto& [target, promise] : waiters) promise.set_exception(error);
+                waiters.clear();
+                pending.clear();
+                space_ready.notify_all();
+                return;
+            }
+            durable.store(through, std::memory_order_release);
+            completeWaiters();
+        }
+    }
+
+    // Called with mutex held
+    void completeWaiters() {
+        const uint64_t done = durable.load(std::memory_order_relaxed);
+        auto last = std::partition(waiters.begin(), waiters.end(), [&](auto& w) { return w.first > done; });
+        for (auto it = last; it != waiters.end(); ++it) it->second.set_value(done);
+        waiters.erase(last, waiters.end());
+    }
+
+public:
+    explicit WriteBehindDB(std::unique_ptr<Database> target,
+                           std::chrono::milliseconds delay = std::chrono::milliseconds(50))
+        : backend(std::move(target)), max_delay(delay), stored_base(backend->storedCount()) {
+        pending.reserve(MAX_BATCH);
+        writer = std::thread([this] { writeLoop(); });
+    }
+
+    ~WriteBehindDB() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        writer.join();
+    }
+
+    WriteBehindDB(const WriteBehindDB&) = delete;
+    WriteBehindDB& operator=(const WriteBehindDB&) = delete;
+
+    uint64_t submit(std::span<const SolarReading> batch) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_ready.wait(lock, [&] { return failure || pending.size() < MAX_PENDING; });
+        rethrowFailure();
+        const bool was_empty = pending.empty();
+        if (was_empty) oldest_pending = std::chrono::steady_clock::now();
+        pending.insert(pending.end(), batch.begin(), batch.end());
+        submitted += batch.size();
+        // The writer sleeps untimed while idle: wake it to start the delay clock
+        if (was_empty || pending.size() >= MAX_BATCH) work_ready.notify_one();
+        return submitted;
+    }
+
+    std::future<uint64_t> flush() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::promise<uint64_t> promise;
+        auto future = promise.get_future();
+        if (failure) {
+            promise.set_exception(failure);
+        } else if (durable.load(std::memory_order_relaxed) >= submitted) {
+            promise.set_value(submitted);
+        } else {
+            waiters.emplace_back(submitted, std::move(promise));
+            flush_requested = true;
+            work_ready.notify_one();
+        }
+        return future;
+    }
+
+    uint64_t durableSequence() const override { return durable.load(std::memory_order_acquire); }
+
+    std::future<std::vector<SolarReading>> queryReadings(time_t start, time_t end) override {
+        return std::async(std::launch::async, [this, start, end] { return getReadings(start, end); });
+    }
+
+    void storeReading(const SolarReading& reading) override { submit(std::span<const SolarReading>(&reading, 1)); }
+    void storeReadings(std::span<const SolarReading> batch) override { submit(batch); }
+
+    std::vector<SolarReading> getReadings(time_t start, time_t end) override {
+        std::vector<SolarReading> result;
+        getReadings(start, end, result);
+        return result;
+    }
+
+    size_t getReadings(time_t start, time_t end, std::vector<SolarReading>& out) override {
+        flush().get();
+        std::lock_guard<std::mutex> guard(backend_mutex);
+        return backend->getReadings(start, end, out);
+    }
+
+    void sync() override { flush().get(); }
+
+    // Counts submitted readings, durable or not, so it matches what ingest has applied
+    uint64_t storedCount() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stored_base + submitted;
+    }
+
+    size_t getStoredSince(uint64_t position, std::vector<SolarReading>& out) override {
+        flush().get();
+        std::lock_guard<std::mutex> guard(backend_mutex);
+        return backend->getStoredSince(position, out);
+    }
+
+    Database& underlying() { return *backend; }
+};
+
+enum class TelemetryFormat { CSV, BINARY };
+
+// Streams telemetry from a file or pipe ("-" for stdin) in large chunks and
+// decodes it directly into a caller-owned batch, so no per-row temporaries or
+// allocations are made once the batch has reached its capacity.
+//
+// CSV rows are: timestamp,power_produced,power_consumed,battery_soc,
+// irradiance,temperature,panel_voltage,panel_current
+// Lines that don't start with a number (headers, comments) are skipped.
+class TelemetryReader {
+    int fd;
+    bool owns_fd;
+    TelemetryFormat format;
+    std::vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool at_eof = false;
+    uint64_t rows_read = 0;
+    uint64_t rows_rejected = 0;
+
+    // Move unread bytes to the front and read another chunk
+    bool refill() {
+        if (at_eof) return false;
+        if (begin > 0) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+        ssize_t n;
+        do {
+            n = ::read(fd, buffer.data() + end, buffer.size() - end);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            at_eof = true;
+            return false;
+        }
+        end += static_cast<size_t>(n);
+        return true;
+    }
+
+    static const char* skipSpaces(const char* p, const char* last) {
+        while (p < last && (*p == ' ' || *p == '\t')) ++p;
+        return p;
+    }
+
+    bool parseLine(const char* p, const char* last, std::vector<SolarReading>& batch) {
+        if (last > p && last[-1] == '\r') --last;
+        p = skipSpaces(p, last);
+        if (p == last) return false;
+        if (!(*p == '-' || *p == '+' || (*p >= '0' && *p <= '9'))) return false; // header or comment
+        if (*p == '+') ++p;
+
+        int64_t timestamp = 0;
+        auto [ts_end, ts_err] = std::from_chars(p, last, timestamp);
+        if (ts_err != std::errc()) {
+            ++rows_rejected;
+            return false;
+        }
+        p = ts_end;
+
+        double fields[7];
+        for (double& field : fields) {
+            p = skipSpaces(p, last);
+            if (p == last || *p != ',') {
+                ++rows_rejected;
+                return false;
+            }
+            p = skipSpaces(p + 1, last);
+            auto [field_end, err] = std::from_chars(p, last, field);
+            if (err != std::errc()) {
+                ++rows_rejected;
+                return false;
+            }
+            p = field_end;
+        }
+        if (skipSpaces(p, last) != last) {
+            ++rows_rejected;
+            return false;
+        }
+
+        batch.emplace_back(static_cast<time_t>(timestamp), fields[0], fields[1], fields[2],
+                           fields[3], fields[4], fields[5], fields[6]);
+        ++rows_read;
+        return true;
+    }
+
+    size_t readCSV(std::vector<SolarReading>& batch, size_t max_rows) {
+        size_t added = 0;
+        while (added < max_rows) {
+            const char* data = buffer.data();
+            auto* newline = static_cast<const char*>(std::memchr(data + begin, '\n', end - begin));
+            if (!newline) {
+                if (refill()) continue;
+                if (begin == end) break;
+                // Last line without a trailing newline
+                newline = data + end;
+            }
+            if (parseLine(data + begin, newline, batch)) ++added;
+            begin = std::min(end, static_cast<size_t>(newline - data) + 1);
+        }
+        return added;
+    }
+
+    size_t readBinary(std::vector<SolarReading>& batch, size_t max_rows) {
+        size_t added = 0;
+        while (added < max_rows) {
+            if (end - begin < sizeof(TelemetryRecord)) {
+                if (refill()) continue;
+                if (begin != end) {
+                    ++rows_rejected; // truncated trailing record
+                    begin = end;
+                }
+                break;
+            }
+            TelemetryRecord record;
+            std::memcpy(&record, buffer.data() + begin, sizeof(record));
+            begin += sizeof(record);
+            batch.emplace_back(static_cast<time_t>(record.timestamp), record.power_produced,
+                               record.power_consumed, record.battery_soc, record.irradiance,
+                               record.temperature, record.panel_voltage, record.panel_current);
+            ++rows_read;
+            ++added;
+        }
+        return added;
+    }
+
+public:
+    TelemetryReader(const std::string& path, TelemetryFormat fmt, size_t chunk_size = 1 << 20)
+        : fd(path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY)),
+          owns_fd(path != "-"),
+          format(fmt),
+          buffer(std::max<size_t>(chunk_size, sizeof(TelemetryRecord))) {
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (fd >= 0) ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    ~TelemetryReader() {
+        if (owns_fd && fd >= 0) ::close(fd);
+    }
+
+    TelemetryReader(const TelemetryReader&) = delete;
+    TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Clears `batch` and refills it with up to max_rows readings.
+    // Returns false once the input is exhausted.
+    bool readBatch(std::vector<SolarReading>& batch, size_t max_rows) {
+        batch.clear();
+        if (format == TelemetryFormat::CSV) readCSV(batch, max_rows);
+        else readBinary(batch, max_rows);
+        return !batch.empty();
+    }
+
+    uint64_t rowsRead() const { return rows_read; }
+    uint64_t rowsRejected() const { return rows_rejected; }
+};
+
+// Panel efficiency: measured output relative to what the rated panel would
+// produce at this irradiance (rating is at 1000 W/m^2)
+inline double panelEfficiency(double irradiance, double power_output, double rated_watts) {
+    if (irradiance <= 0) return 0.0;
+    const double expected_power = irradiance / 1000.0 * rated_watts;
+    return power_output / expected_power;
+}
+
+// Batch kernels over columnar data with runtime CPU dispatch. Every variant
+// performs the same IEEE operations in the same order as the scalar code, so
+// results are bit-identical whichever one runs.
+//   efficiency: out[i] = panelEfficiency(irradiance[i], power[i], rated_watts)
+//   greater_than: bit i of mask is set when values[i] > threshold (NaN never is)
+struct BatchKernels {
+    using EfficiencyFn = void (*)(const double* irradiance, const double* power, double rated_watts,
+                                  double* out, size_t n);
+    using MaskFn = void (*)(const double* values, double threshold, uint64_t* mask, size_t n);
+
+    EfficiencyFn efficiency;
+    MaskFn greater_than;
+    const char* isa;
+
+    static size_t maskWords(size_t n) { return (n + 63) / 64; }
+    static bool testBit(const uint64_t* mask, size_t i) { return (mask[i / 64] >> (i % 64)) & 1; }
+
+    static void efficiencyScalar(const double* irradiance, const double* power, double rated_watts,
+                                 double* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = panelEfficiency(irradiance[i], power[i], rated_watts);
+    }
+
+    static void greaterThanScalar(const double* values, double threshold, uint64_t* mask, size_t n) {
+        std::fill(mask, mask + maskWords(n), 0);
+        for (size_t i = 0; i < n; ++i) {
+            if (values[i] > threshold) mask[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+
+#ifdef SOLAR_SIMD_X86
+    [[gnu::target("avx2")]]
+    static void efficiencyAVX2(const double* irradiance, const double* power, double rated_watts,
+                               double* out, size_t n) {
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d thousand = _mm256_set1_pd(1000.0);
+        const __m256d rated = _mm256_set1_pd(rated_watts);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d irr = _mm256_loadu_pd(irradiance + i);
+            __m256d expected = _mm256_mul_pd(_mm256_div_pd(irr, thousand), rated);
+            __m256d eff = _mm256_div_pd(_mm256_loadu_pd(power + i), expected);
+            __m256d lit = _mm256_cmp_pd(irr, zero, _CMP_NLE_UQ); // !(irr <= 0), true for NaN
+            _mm256_storeu_pd(out + i, _mm256_and_pd(eff, lit));
+        }
+        efficiencyScalar(irradiance + i, power + i, rated_watts, out + i, n - i);
+    }
+
+    [[gnu::target("avx2")]]
+    static void greaterThanAVX2(const double* values, double threshold, uint64_t* mask, size_t n) {
+        std::fill(mask, mask + maskWords(n), 0);
+        const __m256d limit = _mm256_set1_pd(threshold);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d hit = _mm256_cmp_pd(_mm256_loadu_pd(values + i), limit, _CMP_GT_OQ);
+            mask[i / 64] |= static_cast<uint64_t>(_mm256_movemask_pd(hit)) << (i % 64);
+        }
+        for (; i < n; ++i) {
+            if (values[i] > threshold) mask[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+
+    [[gnu::target("avx512f")]]
+    static void efficiencyAVX512(const double* irradiance, const double* power, double rated_watts,
+                                 double* out, size_t n) {
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d thousand = _mm512_set1_pd(1000.0);
+        const __m512d rated = _mm512_set1_pd(rated_watts);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m512d irr = _mm512_loadu_pd(irradiance + i);
+            __m512d expected = _mm512_mul_pd(_mm512_div_pd(irr, thousand), rated);
+            __m512d eff = _mm512_div_pd(_mm512_loadu_pd(power + i), expected);
+            __mmask8 lit = _mm512_cmp_pd_mask(irr, zero, _CMP_NLE_UQ);
+            _mm512_storeu_pd(out + i, _mm512_maskz_mov_pd(lit, eff));
+        }
+        efficiencyScalar(irradiance + i, power + i, rated_watts, out + i, n - i);
+    }
+
+    [[gnu::target("avx512f")]]
+    static void greaterThanAVX512(const double* values, double threshold, uint64_t* mask, size_t n) {
+        std::fill(mask, mask + maskWords(n), 0);
+        const __m512d limit = _mm512_set1_pd(threshold);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __mmask8 hit = _mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), limit, _CMP_GT_OQ);
+            mask[i / 64] |= static_cast<uint64_t>(hit) << (i % 64);
+        }
+        for (; i < n; ++i) {
+            if (values[i] > threshold) mask[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+#endif
+
+#ifdef SOLAR_SIMD_NEON
+    static void efficiencyNEON(const double* irradiance, const double* power, double rated_watts,
+                               double* out, size_t n) {
+        const float64x2_t zero = vdupq_n_f64(0.0);
+        const float64x2_t thousand = vdupq_n_f64(1000.0);
+        const float64x2_t rated = vdupq_n_f64(rated_watts);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            float64x2_t irr = vld1q_f64(irradiance + i);
+            float64x2_t expected = vmulq_f64(vdivq_f64(irr, thousand), rated);
+            float64x2_t eff = vdivq_f64(vld1q_f64(power + i), expected);
+            uint64x2_t dark = vcleq_f64(irr, zero); // false for NaN, like the scalar test
+            vst1q_f64(out + i, vbslq_f64(dark, zero, eff));
+        }
+        efficiencyScalar(irradiance + i, power + i, rated_watts, out + i, n - i);
+    }
+#endif
+
+    // AVX2 is preferred over AVX-512: these kernels are bound by division
+    // throughput, which 512-bit vectors don't improve on most cores, while
+    // they can lower the clock. SOLAR_SIMD=scalar|avx2|avx512f|neon overrides.
+    static BatchKernels select() {
+        BatchKernels kernels{efficiencyScalar, greaterThanScalar, "scalar"};
+        const char* env = std::getenv("SOLAR_SIMD");
+        std::string forced = env ? env : "";
+        if (forced == "scalar") return kernels;
+#ifdef SOLAR_SIMD_X86
+        __builtin_cpu_init();
+        bool avx2 = __builtin_cpu_supports("avx2");
+        bool avx512 = __builtin_cpu_supports("avx512f");
+        if (avx512 && (forced == "avx512f" || !avx2)) {
+            kernels = BatchKernels{efficiencyAVX512, greaterThanAVX512, "avx512f"};
+        } else if (avx2) {
+            kernels = BatchKernels{efficiencyAVX2, greaterThanAVX2, "avx2"};
+        }
+#elif defined(SOLAR_SIMD_NEON)
+        kernels.efficiency = efficiencyNEON;
+        kernels.isa = "neon";
+#endif
+        return kernels;
+    }
+
+    static const BatchKernels& get() {
+        static const BatchKernels kernels = select();
+        return kernels;
+    }
+};
+
+// One alert occurrence, recorded by re-analysis workers before merging
+struct AlertEvent {
+    AlertType type;
+    double severity;
+    time_t timestamp;
+    double value;
+    double threshold;
+};
+
+struct ReanalysisOptions {
+    CheckThresholds thresholds;
+    uint32_t source = 0;
+    double rated_watts = 300.0;
+    double max_charge_rate = MAX_BATTERY_CHARGE_RATE;
+    double max_discharge_rate = MAX_BATTERY_DISCHARGE_RATE;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    time_t chunk_span = 0; // 0 picks about two chunks per thread, at least a day
+};
+
+// Re-runs the maintenance checks over time-sorted history in parallel and
+// returns the alerts a sequential replay through storeReading() would have
+// produced. The range is cut into chunks aligned to DEGRADATION_BUCKET that
+// workers claim from a shared counter. Each worker rebuilds the degradation
+// window from the data before its chunk, starting one rebuild epoch of the
+// window early so the state matches the sequential one exactly, computes
+// efficiencies and the temperature mask with the batch kernels, and records
+// alert events. The efficiency, inverter and battery trackers depend on the
+// whole prefix rather than a bounded window, so a cheap sequential pass first
+// records their state at each chunk start. The events are then merged into
+// one AlertManager in time order.
+inline AlertManager reanalyzeHistory(const ReadingsView& history, const ReanalysisOptions& options) {
+    AlertManager alerts;
+    if (history.empty()) return alerts;
+
+    struct PrefixTrackers {
+        EfficiencyTracker efficiency;
+        InverterTracker inverter;
+        BatteryRateTracker battery;
+    };
+
+    struct Chunk {
+        size_t first;
+        size_t last;
+        PrefixTrackers seed;
+        std::vector<AlertEvent> events;
+    };
+
+    const size_t threads = std::max<size_t>(1, options.threads);
+    const auto& ts = history.timestamp;
+    time_t span = options.chunk_span;
+    if (span <= 0) {
+        time_t total = ts.back() - ts.front() + 1;
+        span = std::max<time_t>(86400, total / static_cast<time_t>(threads * 2) + 1);
+    }
+    span = (span + DEGRADATION_BUCKET - 1) / DEGRADATION_BUCKET * DEGRADATION_BUCKET;
+
+    std::vector<Chunk> chunks;
+    size_t first = 0;
+    while (first < ts.size()) {
+        time_t boundary = (ts[first] / span + 1) * span; // readings are non-negative epoch times
+        auto last = static_cast<size_t>(std::lower_bound(ts.begin() + static_cast<std::ptrdiff_t>(first), ts.end(), boundary) - ts.begin());
+        chunks.push_back(Chunk{first, last, {}, {}});
+        first = last;
+    }
+
+    PrefixTrackers prefix;
+    for (auto& chunk : chunks) {
+        chunk.seed = prefix;
+        for (size_t i = chunk.first; i < chunk.last; ++i) {
+            prefix.efficiency.update(history.irradiance[i], panelEfficiency(history.irradiance[i],
+                                                                            history.power_produced[i],
+                                                                            options.rated_watts));
+            prefix.inverter.update(history.panel_voltage[i] * history.panel_current[i], history.power_produced[i]);
+            prefix.battery.update(ts[i], history.battery_soc[i]);
+        }
+    }
+
+    const BatchKernels& kernels = BatchKernels::get();
+    auto analyze = [&](Chunk& chunk) {
+        // Warm up from the start of the rebuild epoch before the one holding
+        // the chunk's first bucket; see RollingWindowMean::advanceTo
+        const int64_t n = DegradationTracker::WINDOW_BUCKETS;
+        int64_t first_bucket = ts[chunk.first] / DEGRADATION_BUCKET;
+        int64_t epoch_start = first_bucket / n * n;
+        time_t warm_from = static_cast<time_t>((epoch_start - n + 1) * DEGRADATION_BUCKET);
+        auto warm = static_cast<size_t>(
+            std::lower_bound(ts.begin(), ts.begin() + static_cast<std::ptrdiff_t>(chunk.first), warm_from) - ts.begin());
+
+        size_t count = chunk.last - warm;
+        std::vector<double> efficiency(count);
+        std::vector<uint64_t> hot(BatchKernels::maskWords(chunk.last - chunk.first));
+        kernels.efficiency(history.irradiance.data() + warm, history.power_produced.data() + warm,
+                           options.rated_watts, efficiency.data(), count);
+        kernels.greater_than(history.temperature.data() + chunk.first, options.thresholds.temperature,
+                             hot.data(), chunk.last - chunk.first);
+
+        DegradationTracker tracker(chunk.first);
+        for (size_t i = warm; i < chunk.first; ++i) tracker.warmUp(ts[i], efficiency[i - warm]);
+        PrefixTrackers trackers = chunk.seed;
+
+        // Same order as StandardChecks
+        const CheckThresholds& limits = options.thresholds;
+        for (size_t i = chunk.first; i < chunk.last; ++i) {
+            double degradation = tracker.update(ts[i], efficiency[i - warm]);
+            if (degradation > limits.panel_degradation) {
+                chunk.events.push_back(AlertEvent{AlertType::PANEL_DEGRADATION,
+                                                  degradationSeverity(degradation, limits.panel_degradation),
+                                                  ts[i], degradation, limits.panel_degradation});
+            }
+            double ratio = trackers.efficiency.update(history.irradiance[i], efficiency[i - warm]);
+            if (ratio < limits.low_efficiency) {
+                chunk.events.push_back(AlertEvent{AlertType::LOW_EFFICIENCY, ratioSeverity(ratio, limits.low_efficiency),
+                                                  ts[i], ratio, limits.low_efficiency});
+            }
+            double conversion = trackers.inverter.update(history.panel_voltage[i] * history.panel_current[i],
+                                                         history.power_produced[i]);
+            if (conversion < limits.inverter_efficiency) {
+                chunk.events.push_back(AlertEvent{AlertType::INVERTER_ISSUE,
+                                                  ratioSeverity(conversion, limits.inverter_efficiency),
+                                                  ts[i], conversion, limits.inverter_efficiency});
+            }
+            double slope = trackers.battery.update(ts[i], history.battery_soc[i]);
+            double rate_limit = slope >= 0 ? options.max_charge_rate : options.max_discharge_rate;
+            if (std::fabs(slope) > rate_limit) {
+                chunk.events.push_back(AlertEvent{AlertType::BATTERY_DEGRADATION,
+                                                  rateSeverity(std::fabs(slope), rate_limit), ts[i], slope, rate_limit});
+            }
+            if (BatchKernels::testBit(hot.data(), i - chunk.first)) {
+                double temperature = history.temperature[i];
+                chunk.events.push_back(AlertEvent{AlertType::HIGH_TEMPERATURE,
+                                                  temperatureSeverity(temperature, limits.temperature),
+                                                  ts[i], temperature, limits.temperature});
+            }
+        }
+    };
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();) analyze(chunks[i]);
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min(threads, chunks.size()); ++t) pool.emplace_back(work);
+    work();
+    for (auto& thread : pool) thread.join();
+
+    // Expiry is monotonic in time, so expiring at each event and at the end
+    // leaves the same alerts as expiring before every reading
+    for (const auto& chunk : chunks) {
+        for (const auto& event : chunk.events) {
+            alerts.expire(event.timestamp);
+            alerts.raise(event.type, options.source, event.severity, event.timestamp, event.value, event.threshold);
+        }
+    }
+    alerts.expire(ts.back());
+    return alerts;
+}
+
+// Production forecaster updated in O(1) per reading. It keeps exponentially
+// weighted day profiles of irradiance and temperature in 15-minute slots
+// (each day's slot mean folds in once the slot ends) and a weighted panel
+// efficiency normalized to 25 °C. Forecasts scale the profile by recent
+// clearness, which decays back to the profile over a few hours, so hour-ahead
+// follows current weather while day-ahead follows the seasonal shape.
+class ProductionForecaster {
+    static constexpr int SLOTS = 96;
+    static constexpr time_t SLOT_SECONDS = 86400 / SLOTS;
+    static constexpr double DAY_ALPHA = 0.2;             // weight of the newest day in the profile
+    static constexpr double EFFICIENCY_ALPHA = 1.0 / 256; // per daylight sample
+    static constexpr double CLEARNESS_ALPHA = 1.0 / 16;
+    static constexpr double CLEARNESS_DECAY = 2.0 * 3600; // s
+    static constexpr double TEMPERATURE_COEFFICIENT = -0.004; // power change per °C above 25
+    static constexpr double MIN_IRRADIANCE = 200.0;
+
+    struct Slot {
+        double irradiance = 0.0;
+        double temperature = 25.0;
+        bool seen = false;
+    };
+
+    std::array<Slot, SLOTS> profile{};
+    int64_t open_slot = std::numeric_limits<int64_t>::min(); // absolute slot index being accumulated
+    double open_irradiance = 0.0;
+    double open_temperature = 0.0;
+    uint32_t open_count = 0;
+
+    double efficiency = 0.0;
+    bool efficiency_seen = false;
+    double clearness = 1.0;
+    time_t last_timestamp = 0;
+
+    static int slotOf(int64_t absolute) { return static_cast<int>(((absolute % SLOTS) + SLOTS) % SLOTS); }
+
+    static double temperatureFactor(double temperature) {
+        return 1.0 + TEMPERATURE_COEFFICIENT * (temperature - 25.0);
+    }
+
+    void closeSlot() {
+        if (open_count == 0) return;
+        Slot& slot = profile[slotOf(open_slot)];
+        double irradiance = open_irradiance / open_count;
+        double temperature = open_temperature / open_count;
+        if (!slot.seen) {
+            slot = {irradiance, temperature, true};
+        } else {
+            slot.irradiance += DAY_ALPHA * (irradiance - slot.irradiance);
+            slot.temperature += DAY_ALPHA * (temperature - slot.temperature);
+        }
+        open_irradiance = open_temperature = 0.0;
+        open_count = 0;
+    }
+
+    double profilePower(time_t ts, double rated_watts) const {
+        const Slot& slot = profile[slotOf(floorDiv(ts, SLOT_SECONDS))];
+        if (!slot.seen || !efficiency_seen) return 0.0;
+        return slot.irradiance / 1000.0 * rated_watts * efficiency * temperatureFactor(slot.temperature);
+    }
+
+public:
+    void update(const SolarReading& reading, double rated_watts) {
+        const int64_t absolute = floorDiv(reading.timestamp, SLOT_SECONDS);
+        if (absolute < open_slot) return; // late reading; the profile has moved on
+        if (absolute != open_slot) {
+            closeSlot();
+            open_slot = absolute;
+        }
+        open_irradiance += reading.irradiance;
+        open_temperature += reading.temperature;
+        ++open_count;
+        last_timestamp = std::max(last_timestamp, reading.timestamp);
+
+        if (reading.irradiance >= MIN_IRRADIANCE) {
+            double normalized = panelEfficiency(reading.irradiance, reading.power_produced, rated_watts) /
+                                temperatureFactor(reading.temperature);
+            efficiency = efficiency_seen ? efficiency + EFFICIENCY_ALPHA * (normalized - efficiency) : normalized;
+            efficiency_seen = true;
+
+            const Slot& slot = profile[slotOf(absolute)];
+            if (slot.seen && slot.irradiance >= MIN_IRRADIANCE) {
+                double ratio = std::clamp(reading.irradiance / slot.irradiance, 0.0, 2.0);
+                clearness += CLEARNESS_ALPHA * (ratio - clearness);
+            }
+        }
+    }
+
+    void save(CheckpointWriter& out) const { out.put(*this); }
+    void load(CheckpointReader& in) { *this = in.get<ProductionForecaster>(); }
+
+    // Expected production in W at from, from + step, ... for out.size() points
+    void forecast(time_t from, time_t step, double rated_watts, std::span<double> out) const {
+        for (size_t i = 0; i < out.size(); ++i) {
+            const time_t ts = from + static_cast<time_t>(i) * step;
+            const double ahead = static_cast<double>(std::max<time_t>(0, ts - last_timestamp));
+            const double weather = 1.0 + (clearness - 1.0) * std::exp(-ahead / CLEARNESS_DECAY);
+            out[i] = profilePower(ts, rated_watts) * weather;
+        }
+    }
+};
+
+// Battery limits seen by the load scheduler; rates are capacity fractions per hour
+struct BatteryLimits {
+    double capacity_wh = 10000.0;
+    double max_charge_rate = MAX_BATTERY_CHARGE_RATE;
+    double max_discharge_rate = MAX_BATTERY_DISCHARGE_RATE;
+    double reserve_soc = 20.0;
+};
+
+struct LoadDecision {
+    uint32_t enabled = 0;       // bit i set: loads[i] runs this interval
+    int priority = 0;           // total priority of the enabled loads
+    double load_power = 0.0;    // W drawn by the enabled loads
+    double battery_power = 0.0; // W into the battery, negative when discharging
+    double curtailed = 0.0;     // W of production neither used nor stored
+
+    bool runs(size_t load) const { return (enabled >> load) & 1u; }
+};
+
+// Chooses which loads run each interval: the highest total priority whose
+// power fits in production plus what the battery may deliver, preferring the
+// lower draw on ties. All 2^n subsets of the (at most MAX_LOADS) loads are
+// enumerated once and sorted by power with a running best, so a decision is
+// one binary search over 1024 entries and never allocates.
+class LoadScheduler {
+    struct Choice {
+        double power;
+        uint32_t best_mask;  // best subset with power <= this entry's power
+        int best_priority;
+        double best_power;
+    };
+
+    std::vector<Load> loads;
+    std::vector<Choice> choices;
+    BatteryLimits battery;
+
+public:
+    LoadScheduler(std::vector<Load> schedulable, const BatteryLimits& limits = {})
+        : loads(std::move(schedulable)), battery(limits) {
+        if (loads.size() > MAX_LOADS) throw std::runtime_error("LoadScheduler supports at most MAX_LOADS loads");
+        for (const auto& load : loads) {
+            if (!(load.power >= 0)) throw std::runtime_error("Load " + load.name + " has negative power");
+        }
+
+        const uint32_t subsets = 1u << loads.size();
+        std::vector<std::pair<double, uint32_t>> by_power;
+        std::vector<int> priorities(subsets, 0);
+        by_power.reserve(subsets);
+        for (uint32_t mask = 0; mask < subsets; ++mask) {
+            double power = 0.0;
+            for (size_t i = 0; i < loads.size(); ++i) {
+                if (mask & (1u << i)) {
+                    power += loads[i].power;
+                    priorities[mask] += loads[i].priority;
+                }
+            }
+            by_power.emplace_back(power, mask);
+        }
+        std::sort(by_power.begin(), by_power.end());
+
+        choices.reserve(subsets);
+        Choice best{0.0, 0, 0, 0.0};
+        for (const auto& [power, mask] : by_power) {
+            if (priorities[mask] > best.best_priority) {
+                best.best_mask = mask;
+                best.best_priority = priorities[mask];
+                best.best_power = power;
+            }
+            best.power = power;
+            choices.push_back(best);
+        }
+    }
+
+    // Decide for an interval of interval_s seconds given current production and SOC (%)
+    LoadDecision decide(double power_produced, double battery_soc, double interval_s = 60.0) const {
+        const double hours = std::max(interval_s, 1.0) / 3600.0;
+        const double stored_wh = std::max(0.0, battery_soc - battery.reserve_soc) / 100.0 * battery.capacity_wh;
+        const double headroom_wh = std::max(0.0, 100.0 - battery_soc) / 100.0 * battery.capacity_wh;
+        const double max_discharge = std::min(battery.max_discharge_rate * battery.capacity_wh, stored_wh / hours);
+        const double max_charge = std::min(battery.max_charge_rate * battery.capacity_wh, headroom_wh / hours);
+        const double budget = std::max(0.0, power_produced) + max_discharge;
+
+        auto it = std::upper_bound(choices.begin(), choices.end(), budget,
+                                   [](double value, const Choice& c) { return value < c.power; });
+        LoadDecision decision;
+        if (it != choices.begin()) {
+            const Choice& choice = *std::prev(it);
+            decision.enabled = choice.best_mask;
+            decision.priority = choice.best_priority;
+            decision.load_power = choice.best_power;
+        }
+        const double surplus = power_produced - decision.load_power;
+        decision.battery_power = std::clamp(surplus, -max_discharge, max_charge);
+        decision.curtailed = std::max(0.0, surplus - max_charge);
+        return decision;
+    }
+
+    const std::vector<Load>& schedulableLoads() const { return loads; }
+};
+
+// A checkpoint as the ingest thread hands it off: the small state already
+// serialized, and only the changes to the large stores since the previous
+// snapshot. CheckpointMirror turns a sequence of these into checkpoint bytes.
+struct CheckpointSnapshot {
+    std::string state;
+    RollupStore::Changes rollups;
+    QuantileStore::Changes quantiles;
+    PowerHistory::Changes power_history;
+};
+
+// Per-site engine. Checks is the maintenance-check pipeline; sites with
+// extra detectors instantiate it with their own DetectorPipeline.
+template <typename Checks = StandardChecks>
+class BasicSolarOptimizer {
+    std::unique_ptr<Database> db;
+    uint32_t source_id;
+    AlertManager active_alerts;
+    Checks checks;
+    std::unique_ptr<LoadScheduler> scheduler;
+    ProductionForecaster forecaster;
+    EnvironmentalImpact environmental_impact;
+    RollupStore rollups;
+    QuantileStore quantiles;
+    time_t latest_timestamp = 0;
+    ReorderBuffer reorder;
+    PowerHistory power_history;
+    LateReadingStats late_stats;
+    std::vector<SolarReading> released;
+
+    // Published configuration. A version is freed when the last reader holding
+    // it lets go, so repeated reloads don't accumulate. Ingest keeps its own
+    // reference and takes the mutex only when the generation has moved, which
+    // keeps its per-reading cost at one acquire load.
+    mutable std::mutex config_mutex;
+    std::shared_ptr<const ActiveSiteConfig> config; // guarded by config_mutex
+    std::atomic<uint64_t> config_generation{0};
+    mutable std::shared_ptr<const ActiveSiteConfig> ingest_config; // ingest thread only
+    mutable uint64_t ingest_generation = 0;
+
+    // Scratch columns for batch kernels, reused across batches
+    std::vector<double> batch_irradiance;
+    std::vector<double> batch_power;
+    std::vector<double> batch_temperature;
+    std::vector<double> batch_efficiency;
+    std::vector<uint64_t> batch_hot;
+
+    // The configuration as ingest sees it; the reference stays valid until the
+    // next call, so ingest paths read it once per reading or batch
+    const ActiveSiteConfig& activeConfig() const {
+        const uint64_t generation = config_generation.load(std::memory_order_acquire);
+        if (generation != ingest_generation) {
+            std::lock_guard<std::mutex> lock(config_mutex);
+            ingest_config = config;
+            ingest_generation = generation;
+        }
+        return *ingest_config;
+    }
+
+    // For readers off the ingest thread
+    std::shared_ptr<const ActiveSiteConfig> sharedConfig() const {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        return config;
+    }
+    
+    // Calculate panel efficiency
+    double calculate_efficiency(double irradiance, double power_output) const {
+        return panelEfficiency(irradiance, power_output, activeConfig().site.panel_rated_watts);
+    }
+
+    void runChecks(const SolarReading& reading) {
+        const ActiveSiteConfig& active = activeConfig();
+        withSiteProfile(active.profile, [&](auto profile) {
+            using Profile = decltype(profile);
+            const SiteConfig& site = active.site;
+            AlertSink sink{active_alerts, source_id};
+            CheckInput in{reading,
+                          panelEfficiency(reading.irradiance, reading.power_produced, Profile::ratedWatts(site)),
+                          reading.temperature > Profile::temperatureLimit(site)};
+            checks.run(in, site, profile, sink);
+        });
+    }
+
+    // Everything in a checkpoint before the large stores
+    void saveSmallState(CheckpointWriter& out) const {
+        out.buffer().append(CHECKPOINT_MAGIC);
+        out.put(CHECKPOINT_VERSION);
+        out.put(source_id);
+        out.put(latest_timestamp);
+        out.put(db->storedCount());
+        active_alerts.save(out);
+        checks.save(out);
+        environmental_impact.save(out);
+        forecaster.save(out);
+        reorder.save(out);
+        out.put(late_stats);
+    }
+
+public:
+    BasicSolarOptimizer(std::unique_ptr<Database> database, uint32_t source = 0, const SiteConfig& site = {})
+        : db(std::move(database)), source_id(source) {
+        publishConfig(site);
+    }
+    
+    void storeReading(const SolarReading& reading) {
+        SOLAR_METRIC_TIMER(STORE_READING);
+        SOLAR_METRIC_COUNT(READINGS_INGESTED, 1);
+        {
+            SOLAR_METRIC_TIMER(DB_WRITE);
+            db->storeReading(reading);
+        }
+        latest_timestamp = std::max(latest_timestamp, reading.timestamp);
+        power_history.append(reading.timestamp, reading.power_produced);
+        environmental_impact.addSample(source_id, reading.timestamp, reading.power_produced);
+        forecaster.update(reading, activeConfig().site.panel_rated_watts);
+        rollups.add(reading);
+        quantiles.add(reading, calculate_efficiency(reading.irradiance, reading.power_produced));
+        performMaintenanceChecks(reading);
+    }
+
+    // Ingest readings that may arrive out of order, up to the site's
+    // reorder_window behind the newest. They're held in the reorder buffer and
+    // released in time order to storeReadings(), so the streaming checks see
+    // an ordered stream; anything older than what was already released goes
+    // to the correction path instead.
+    void submitReadings(std::span<const SolarReading> readings) {
+        for (const auto& reading : readings) {
+            if (!reorder.push(reading)) correctLateReading(reading);
+        }
+        released.clear();
+        reorder.release(activeConfig().site.reorder_window, released);
+        storeReadings(released);
+    }
+
+    // Release everything held in the reorder buffer (end of stream)
+    void flushReorderBuffer() {
+        released.clear();
+        reorder.releaseAll(released);
+        storeReadings(released);
+    }
+
+    // Correction path for a reading older than ones already checked: it is
+    // stored, and spliced into the energy totals and the rollups between its
+    // neighbours in O(log n). The checks aren't re-run and nothing is
+    // recomputed; exact repeats of a sample are dropped.
+    void correctLateReading(const SolarReading& reading) {
+        if (applyLateReading(reading)) db->storeReading(reading);
+    }
+
+    // Everything correctLateReading() derives, without the database write;
+    // false if the reading was a duplicate and is to be dropped
+    bool applyLateReading(const SolarReading& reading) {
+        const PowerSample late{reading.timestamp, reading.power_produced};
+        std::optional<PowerSample> prev, next;
+        switch (power_history.insert(late, prev, next)) {
+        case PowerHistory::Splice::DUPLICATE:
+            ++late_stats.duplicates;
+            return false;
+        case PowerHistory::Splice::TOO_OLD:
+            ++late_stats.uncorrected; // kept in storage and statistics only
+            break;
+        case PowerHistory::Splice::INSERTED:
+            ++late_stats.corrected;
+            environmental_impact.spliceSample(prev, late, next);
+            break;
+        }
+        rollups.addLate(reading, prev, next);
+        quantiles.add(reading, calculate_efficiency(reading.irradiance, reading.power_produced));
+        return true;
+    }
+
+    // Batch equivalent of calling storeReading() for each element in order
+    void storeReadings(std::span<const SolarReading> readings) {
+        if (readings.empty()) return;
+        SOLAR_METRIC_TIMER(STORE_BATCH);
+        SOLAR_METRIC_COUNT(READINGS_INGESTED, readings.size());
+        {
+            SOLAR_METRIC_TIMER(DB_WRITE);
+            db->storeReadings(readings);
+        }
+        applyReadings(readings);
+    }
+
+    // Everything storeReadings() derives from a batch, without the database write
+    void applyReadings(std::span<const SolarReading> readings) {
+        if (readings.empty()) return;
+        const double rated_watts = activeConfig().site.panel_rated_watts;
+        for (const auto& reading : readings) {
+            latest_timestamp = std::max(latest_timestamp, reading.timestamp);
+            power_history.append(reading.timestamp, reading.power_produced);
+            environmental_impact.addSample(source_id, reading.timestamp, reading.power_produced);
+            forecaster.update(reading, rated_watts);
+        }
+        rollups.add(readings);
+
+        // Efficiency and the temperature test are computed for the whole batch
+        // with SIMD kernels; the stateful part of the checks then runs in order.
+        // The configuration is read once, so an update applies from the next batch.
+        const ActiveSiteConfig& active = activeConfig();
+        const SiteConfig& site = active.site;
+        const size_t n = readings.size();
+        batch_irradiance.resize(n);
+        batch_power.resize(n);
+        batch_temperature.resize(n);
+        batch_efficiency.resize(n);
+        batch_hot.resize(BatchKernels::maskWords(n));
+        for (size_t i = 0; i < n; ++i) {
+            batch_irradiance[i] = readings[i].irradiance;
+            batch_power[i] = readings[i].power_produced;
+            batch_temperature[i] = readings[i].temperature;
+        }
+        const BatchKernels& kernels = BatchKernels::get();
+        kernels.efficiency(batch_irradiance.data(), batch_power.data(), site.panel_rated_watts,
+                           batch_efficiency.data(), n);
+        kernels.greater_than(batch_temperature.data(), site.thresholds.temperature, batch_hot.data(), n);
+        for (size_t i = 0; i < n; ++i) quantiles.add(readings[i], batch_efficiency[i]);
+
+        SOLAR_METRIC_TIMER(CHECKS);
+        withSiteProfile(active.profile, [&](auto profile) {
+            AlertSink sink{active_alerts, source_id};
+            for (size_t i = 0; i < n; ++i) {
+                active_alerts.expire(readings[i].timestamp);
+                CheckInput in{readings[i], batch_efficiency[i], BatchKernels::testBit(batch_hot.data(), i)};
+                checks.run(in, site, profile, sink);
+            }
+        });
+    }
+    
+    // Forecast production in W at from, from + step, ... filling out; O(out.size())
+    void generateForecast(time_t from, time_t step, std::span<double> out) const {
+        forecaster.forecast(from, step, activeConfig().site.panel_rated_watts, out);
+    }
+
+    // Loads the scheduler may switch; at most the site's max_loads
+    void setLoads(std::vector<Load> schedulable) {
+        const auto active = sharedConfig();
+        const SiteConfig& site = active->site;
+        if (schedulable.size() > site.max_loads) throw std::runtime_error("More loads than the site's max_loads");
+        BatteryLimits limits{site.battery_capacity_wh, site.max_battery_charge_rate,
+                             site.max_battery_discharge_rate, site.battery_reserve_soc};
+        scheduler = std::make_unique<LoadScheduler>(std::move(schedulable), limits);
+    }
+
+    // Which loads to run for the next interval_s seconds after this reading
+    LoadDecision optimizeEnergyUsage(const SolarReading& reading, double interval_s = 60.0) const {
+        if (!scheduler) return {};
+        return scheduler->decide(reading.power_produced, reading.battery_soc, interval_s);
+    }
+
+    void performMaintenanceChecks(const SolarReading& reading) {
+        SOLAR_METRIC_TIMER(CHECKS);
+        // Clear old alerts, using replay time rather than wall-clock time
+        active_alerts.expire(reading.timestamp);
+        runChecks(reading);
+    }
+
+    void printMaintenanceAlerts() const {
+        if (active_alerts.empty()) {
+            std::cout << "No active maintenance alerts\n";
+            return;
+        }
+        
+        std::vector<MaintenanceAlert> alerts = active_alerts.active();
+        std::sort(alerts.begin(), alerts.end(), [](const auto& a, const auto& b) {
+            return a.first_seen < b.first_seen;
+        });
+        std::cout << "\n=== MAINTENANCE ALERTS ===\n";
+        for (const auto& alert : alerts) {
+            alert.print();
+        }
+    }
+    
+    void generateEnvironmentalReport() const {
+        environmental_impact.generateReport();
+    }
+
+    // Atomically switch to a new configuration; safe to call while another
+    // thread is ingesting, which picks it up with its next reading or batch
+    void publishConfig(const SiteConfig& site) {
+        auto version = std::make_shared<const ActiveSiteConfig>(ActiveSiteConfig{site, matchSiteProfile(site)});
+        std::lock_guard<std::mutex> lock(config_mutex);
+        config.swap(version); // the old version is released after the lock
+        config_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    SiteConfig siteConfig() const { return sharedConfig()->site; }
+
+    void setThresholds(const CheckThresholds& limits) {
+        SiteConfig site = siteConfig();
+        site.thresholds = limits;
+        publishConfig(site);
+    }
+
+    CheckThresholds checkThresholds() const { return sharedConfig()->site.thresholds; }
+
+    // Alerts that the checks would have raised over [start, end] with other
+    // thresholds, computed in parallel from the stored readings
+    AlertManager reanalyze(time_t start, time_t end, const CheckThresholds& limits, size_t threads = 0) {
+        ReanalysisOptions options;
+        options.thresholds = limits;
+        options.source = source_id;
+        const auto active = sharedConfig();
+        const SiteConfig& site = active->site;
+        options.rated_watts = site.panel_rated_watts;
+        options.max_charge_rate = site.max_battery_charge_rate;
+        options.max_discharge_rate = site.max_battery_discharge_rate;
+        if (threads > 0) options.threads = threads;
+        if (auto* columnar = dynamic_cast<ColumnarDB*>(db.get())) {
+            return reanalyzeHistory(columnar->viewReadings(start, end), options);
+        }
+        ColumnarDB copy;
+        copy.storeReadings(db->getReadings(start, end));
+        return reanalyzeHistory(copy.viewReadings(start, end), options);
+    }
+
+    // Serialized derived state (alerts, detector state, energy totals,
+    // forecaster, reorder buffer, late-reading counts, then the large stores:
+    // rollups, quantile sketches and power history) and the database position
+    // it covers. The readings themselves stay in the database; restore() plus
+    // replayFromDatabase() rebuilds the optimizer's state, except that
+    // duplicates dropped after the checkpoint were never stored and aren't
+    // counted again.
+    std::string checkpoint() const {
+        CheckpointWriter out;
+        saveSmallState(out);
+        rollups.save(out);
+        quantiles.save(out);
+        power_history.save(out);
+        return std::move(out.buffer());
+    }
+
+    // The same checkpoint for a background writer: the large stores contribute
+    // only what changed since the previous snapshot, so the cost here follows
+    // the ingest rate rather than the retained history
+    CheckpointSnapshot snapshot() {
+        CheckpointWriter out;
+        saveSmallState(out);
+        return {std::move(out.buffer()), rollups.takeChanges(), quantiles.takeChanges(), power_history.takeChanges()};
+    }
+
+    // Replace the derived state with a checkpoint; returns the database
+    // position (storedCount()) it covers. State is untouched if the checkpoint
+    // is invalid.
+    uint64_t restore(std::string_view bytes) {
+        if (!bytes.starts_with(CHECKPOINT_MAGIC)) throw std::runtime_error("Not a checkpoint file");
+        CheckpointReader in(bytes.substr(CHECKPOINT_MAGIC.size()));
+        if (in.get<uint32_t>() != CHECKPOINT_VERSION) throw std::runtime_error("Unsupported checkpoint version");
+        if (in.get<uint32_t>() != source_id) throw std::runtime_error("Checkpoint is for a different source");
+        const time_t latest = in.get<time_t>();
+        const uint64_t position = in.get<uint64_t>();
+        AlertManager alerts;
+        Checks restored_checks;
+        EnvironmentalImpact impact;
+        ProductionForecaster restored_forecaster;
+        ReorderBuffer restored_reorder;
+        RollupStore restored_rollups;
+        QuantileStore restored_quantiles;
+        PowerHistory history;
+        alerts.load(in);
+        restored_checks.load(in);
+        impact.load(in);
+        restored_forecaster.load(in);
+        restored_reorder.load(in);
+        const auto late = in.get<LateReadingStats>();
+        restored_rollups.load(in);
+        restored_quantiles.load(in);
+        history.load(in);
+        if (!in.done()) throw std::runtime_error("Trailing data in checkpoint");
+
+        latest_timestamp = latest;
+        active_alerts = std::move(alerts);
+        checks = std::move(restored_checks);
+        environmental_impact = std::move(impact);
+        rollups = std::move(restored_rollups);
+        quantiles = std::move(restored_quantiles);
+        forecaster = restored_forecaster;
+        reorder = std::move(restored_reorder);
+        power_history = std::move(history);
+        late_stats = late;
+        return position;
+    }
+
+    // Re-derive state from the readings stored after position, in the order
+    // they were stored; returns how many were replayed. Each reading takes the
+    // path it took when it arrived: one older than what the reorder buffer had
+    // released was a late correction, the rest were released in time order,
+    // and those the restored buffer still held are dropped from it.
+    size_t replayFromDatabase(uint64_t position) {
+        std::vector<SolarReading> readings;
+        db->getStoredSince(position, readings);
+        auto run = readings.begin();
+        while (run != readings.end()) {
+            if (run->timestamp < reorder.releasedThrough()) {
+                applyLateReading(*run++);
+                continue;
+            }
+            auto end = std::next(run);
+            while (end != readings.end() && end->timestamp >= std::prev(end)->timestamp) ++end;
+            applyReadings(std::span<const SolarReading>(&*run, static_cast<size_t>(end - run)));
+            reorder.markReleased(std::prev(end)->timestamp);
+            run = end;
+        }
+        return readings.size();
+    }
+
+    time_t latestTimestamp() const { return latest_timestamp; }
+    const LateReadingStats& lateReadingStats() const { return late_stats; }
+    size_t reorderBuffered() const { return reorder.size(); }
+
+    const EnvironmentalImpact& environmentalImpact() const { return environmental_impact; }
+    const RollupStore& rollupStore() const { return rollups; }
+    const QuantileStore& quantileStore() const { return quantiles; }
+    const std::vector<MaintenanceAlert>& activeAlerts() const { return active_alerts.active(); }
+    const Checks& maintenanceChecks() const { return checks; }
+};
+
+using SolarOptimizer = BasicSolarOptimizer<>;
+
+// Fleet-level engine: site IDs are sharded across worker threads and each
+// worker owns the SolarOptimizer of every site it serves, so ingest never
+// takes a shared lock. Producers hand readings to a worker through its
+// lock-free queue; reports merge the per-site state after drain(). Both
+// factories are called from worker threads when a site is first seen.
+class FleetOptimizer {
+public:
+    using DatabaseFactory = std::function<std::unique_ptr<Database>(uint32_t site)>;
+    using ConfigFactory = std::function<SiteConfig(uint32_t site)>;
+
+private:
+    struct SiteReading {
+        uint32_t site;
+        SolarReading reading;
+    };
+
+    struct Site {
+        std::unique_ptr<SolarOptimizer> optimizer;
+        std::vector<SolarReading> batch;
+    };
+
+    struct alignas(64) Worker {
+        BoundedQueue<SiteReading> queue;
+        std::unordered_map<uint32_t, Site> sites;
+        std::vector<uint32_t> touched;
+        std::atomic<uint64_t> submitted{0};
+        alignas(64) std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> flushed{0}; // last drain() whose reorder flush is done
+        std::thread thread;
+
+        explicit Worker(size_t capacity) : queue(capacity) {}
+    };
+
+    static constexpr size_t MAX_DRAIN = 4096;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    DatabaseFactory make_db;
+    ConfigFactory make_config;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> flush_requests{0};
+
+    Site& siteFor(Worker& worker, uint32_t id) {
+        auto it = worker.sites.find(id);
+        if (it == worker.sites.end()) {
+            Site site{std::make_unique<SolarOptimizer>(make_db(id), id, make_config(id)), {}};
+            it = worker.sites.emplace(id, std::move(site)).first;
+        }
+        return it->second;
+    }
+
+    void run(Worker& worker) {
+        SiteReading item{0, SolarReading(0, 0, 0, 0, 0, 0, 0, 0)};
+        for (;;) {
+            size_t drained = 0;
+            while (drained < MAX_DRAIN && worker.queue.tryPop(item)) {
+                Site& site = siteFor(worker, item.site);
+                if (site.batch.empty()) worker.touched.push_back(item.site);
+                site.batch.push_back(item.reading);
+                ++drained;
+            }
+
+            // Readings of one site stay in arrival order within its batch
+            for (uint32_t id : worker.touched) {
+                Site& site = worker.sites.find(id)->second;
+                site.optimizer->submitReadings(site.batch);
+                site.batch.clear();
+            }
+            worker.touched.clear();
+
+            if (drained > 0) {
+                worker.processed.fetch_add(drained, std::memory_order_release);
+                continue;
+            }
+            const uint64_t requested = flush_requests.load(std::memory_order_acquire);
+            if (worker.flushed.load(std::memory_order_relaxed) < requested) {
+                for (auto& [id, site] : worker.sites) site.optimizer->flushReorderBuffer();
+                worker.flushed.store(requested, std::memory_order_release);
+                continue;
+            }
+            if (!running.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    static void pinToCore(std::thread& thread, size_t core) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)core;
+#endif
+    }
+
+public:
+    explicit FleetOptimizer(size_t worker_count = std::max(1u, std::thread::hardware_concurrency()),
+                            DatabaseFactory factory = [](uint32_t) { return std::make_unique<ColumnarDB>(); },
+                            size_t queue_capacity = 1 << 16,
+                            ConfigFactory configs = [](uint32_t) { return SiteConfig{}; })
+        : make_db(std::move(factory)), make_config(std::move(configs)) {
+        worker_count = std::max<size_t>(1, worker_count);
+        workers.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.push_back(std::make_unique<Worker>(queue_capacity));
+        }
+        for (size_t i = 0; i < worker_count; ++i) {
+            Worker& worker = *workers[i];
+            worker.thread = std::thread(&FleetOptimizer::run, this, std::ref(worker));
+            pinToCore(worker.thread, i);
+        }
+    }
+
+    ~FleetOptimizer() {
+        running.store(false, std::memory_order_release);
+        for (auto& worker : workers) worker->thread.join();
+    }
+
+    FleetOptimizer(const FleetOptimizer&) = delete;
+    FleetOptimizer& operator=(const FleetOptimizer&) = delete;
+
+    size_t workerCount() const { return workers.size(); }
+
+    // Readings accepted and processed so far, over all workers
+    uint64_t submittedCount() const {
+        uint64_t total = 0;
+        for (const auto& worker : workers) total += worker->submitted.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t processedCount() const {
+        uint64_t total = 0;
+        for (const auto& worker : workers) total += worker->processed.load(std::memory_order_acquire);
+        return total;
+    }
+
+    // Non-blocking; returns false if the owning worker's queue is full
+    bool trySubmit(uint32_t site, const SolarReading& reading) {
+        Worker& worker = *workers[site % workers.size()];
+        if (!worker.queue.tryPush(SiteReading{site, reading})) return false;
+        worker.submitted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Applies backpressure by yielding until the worker has room
+    void submit(uint32_t site, const SolarReading& reading) {
+        while (!trySubmit(site, reading)) std::this_thread::yield();
+    }
+
+    // Wait until every submitted reading has been processed, including those
+    // held in the sites' reorder buffers, which are flushed as at the end of a
+    // stream. The report methods below must only be called after drain()
+    // while no submits are in flight.
+    void drain() {
+        const uint64_t request = flush_requests.fetch_add(1, std::memory_order_acq_rel) + 1;
+        for (const auto& worker : workers) {
+            uint64_t target = worker->submitted.load(std::memory_order_relaxed);
+            while (worker->processed.load(std::memory_order_acquire) < target ||
+                   worker->flushed.load(std::memory_order_acquire) < request) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    size_t siteCount() const {
+        size_t count = 0;
+        for (const auto& worker : workers) count += worker->sites.size();
+        return count;
+    }
+
+    EnvironmentalImpact fleetEnvironmentalImpact() const {
+        EnvironmentalImpact total;
+        for (const auto& worker : workers) {
+            for (const auto& [id, site] : worker->sites) total.merge(site.optimizer->environmentalImpact());
+        }
+        return total;
+    }
+
+    // Each site's quantile sketches over [start, end), ordered by site ID, to rank underperformers
+    std::vector<std::pair<uint32_t, QuantileSketches>> siteQuantiles(time_t start, time_t end) const {
+        std::vector<std::pair<uint32_t, QuantileSketches>> result;
+        for (const auto& worker : workers) {
+            for (const auto& [id, site] : worker->sites) {
+                result.emplace_back(id, site.optimizer->quantileStore().query(start, end));
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+    // Fleet-wide sketches over [start, end): the merge of every site's
+    QuantileSketches fleetQuantiles(time_t start, time_t end) const {
+        QuantileSketches total;
+        for (const auto& worker : workers) {
+            for (const auto& [id, site] : worker->sites) total.merge(site.optimizer->quantileStore().query(start, end));
+        }
+        return total;
+    }
+
+    // Alerts of every site, ordered by site ID and then first occurrence
+    std::vector<MaintenanceAlert> fleetAlerts() const {
+        std::vector<MaintenanceAlert> alerts;
+        for (const auto& worker : workers) {
+            for (const auto& [id, site] : worker->sites) {
+                const auto& site_alerts = site.optimizer->activeAlerts();
+                alerts.insert(alerts.end(), site_alerts.begin(), site_alerts.end());
+            }
+        }
+        std::sort(alerts.begin(), alerts.end(), [](const auto& a, const auto& b) {
+            return a.source != b.source ? a.source < b.source : a.first_seen < b.first_seen;
+        });
+        return alerts;
+    }
+
+    void printFleetReport() const {
+        auto alerts = fleetAlerts();
+        std::cout << "\n=== FLEET MAINTENANCE ALERTS (" << siteCount() << " sites) ===\n";
+        if (alerts.empty()) std::cout << "No active maintenance alerts\n";
+        for (const auto& alert : alerts) {
+            std::cout << "Site " << alert.source << " ";
+            alert.print();
+        }
+        fleetEnvironmentalImpact().generateReport();
+    }
+};
+
+#ifdef __linux__
+struct IngestStats {
+    uint64_t datagrams = 0;
+    uint64_t udp_records = 0;
+    uint64_t tcp_records = 0;
+    uint64_t bytes_rejected = 0;    // partial records: datagram tails, TCP bytes before close, unqueued at stop
+    uint64_t udp_dropped = 0;       // records lost because the queue was full
+    uint64_t tcp_pauses = 0;        // times a connection stopped being read for backpressure
+    uint64_t connections = 0;       // accepted so far
+    uint64_t stored = 0;            // records handed to the optimizer
+    uint64_t batches = 0;
+    size_t queue_depth = 0;
+    size_t queue_high_water = 0;
+    size_t queue_capacity = 0;
+};
+
+// Network ingest for one site: TelemetryRecords (the --binary format) arrive
+// as UDP datagrams of whole records or as a TCP byte stream on the same port.
+// One epoll thread receives with recvmmsg into preallocated buffers and pushes
+// records into a BoundedQueue; a consumer thread pops them into a reused
+// batch for SolarOptimizer::storeReadings(). When the queue is full, UDP
+// records are dropped and counted, while TCP connections stop being read until
+// the queue is half empty, so backpressure reaches the sender. A peer that
+// hangs up meanwhile is closed only after its buffered records are queued.
+class IngestServer {
+    static constexpr size_t UDP_MESSAGES = 32;
+    static constexpr size_t UDP_BUFFER = 65536;
+    static constexpr size_t TCP_BUFFER = 64 * 1024;
+    static constexpr size_t STORE_BATCH = 4096;
+    static constexpr int MAX_EVENTS = 64;
+
+    struct Connection {
+        int fd;
+        std::vector<char> buffer;
+        size_t begin = 0;
+        size_t end = 0;
+        bool paused = false;
+        bool hung_up = false; // peer closed or failed; closed once its buffer is queued
+        bool watched = true;  // in the epoll set
+    };
+
+    SolarOptimizer& optimizer;
+    std::function<void()> after_batch;
+    BoundedQueue<TelemetryRecord> queue;
+    int epoll_fd = -1;
+    int udp_fd = -1;
+    int listen_fd = -1;
+    int wake_fd = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<Connection*> paused;
+
+    std::vector<char> udp_storage;
+    std::array<mmsghdr, UDP_MESSAGES> messages{};
+    std::array<iovec, UDP_MESSAGES> vectors{};
+
+    std::atomic<bool> running{false};
+    std::thread loop_thread;
+    std::thread consumer_thread;
+
+    std::atomic<uint64_t> datagrams{0}, udp_records{0}, tcp_records{0}, bytes_rejected{0};
+    std::atomic<uint64_t> udp_dropped{0}, tcp_pauses{0}, accepted{0}, stored{0}, batches{0};
+    std::atomic<size_t> high_water{0};
+
+    static void check(int result, const char* what) {
+        if (result < 0) throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+    }
+
+    void watch(int fd, uint32_t events, int op = EPOLL_CTL_ADD) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        check(::epoll_ctl(epoll_fd, op, fd, &event), "epoll_ctl");
+    }
+
+    int bindSocket(int type, uint16_t port) {
+        int fd = ::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        check(fd, "socket");
+        int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("bind port " + std::to_string(port) + ": " + std::strerror(error));
+        }
+        return fd;
+    }
+
+    void noteDepth() {
+        size_t depth = queue.sizeApprox();
+        if (depth > high_water.load(std::memory_order_relaxed)) high_water.store(depth, std::memory_order_relaxed);
+    }
+
+    void receiveDatagrams() {
+        for (int round = 0; round < 4; ++round) { // bounded so TCP isn't starved
+            int n = ::recvmmsg(udp_fd, messages.data(), UDP_MESSAGES, MSG_DONTWAIT, nullptr);
+            if (n <= 0) return;
+            uint64_t records = 0, dropped = 0, rejected = 0;
+            for (int m = 0; m < n; ++m) {
+                const char* data = static_cast<const char*>(vectors[m].iov_base);
+                const size_t count = messages[m].msg_len / sizeof(TelemetryRecord);
+                rejected += messages[m].msg_len % sizeof(TelemetryRecord);
+                for (size_t i = 0; i < count; ++i) {
+                    TelemetryRecord record;
+                    std::memcpy(&record, data + i * sizeof(record), sizeof(record));
+                    if (!queue.tryPush(record)) {
+                        dropped += count - i;
+                        break;
+                    }
+                    ++records;
+                }
+            }
+            datagrams.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            udp_records.fetch_add(records, std::memory_order_relaxed);
+            udp_dropped.fetch_add(dropped, std::memory_order_relaxed);
+            bytes_rejected.fetch_add(rejected, std::memory_order_relaxed);
+            noteDepth();
+            if (n < static_cast<int>(UDP_MESSAGES)) return;
+        }
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            auto connection = std::make_unique<Connection>(Connection{fd, std::vector<char>(TCP_BUFFER)});
+            watch(fd, EPOLLIN | EPOLLRDHUP);
+            connections.emplace(fd, std::move(connection));
+            accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void closeConnection(Connection& connection) {
+        if (connection.paused) paused.erase(std::find(paused.begin(), paused.end(), &connection));
+        const int fd = connection.fd;
+        ::close(fd); // also removes it from the epoll set
+        connections.erase(fd);
+    }
+
+    // Push the buffered whole records; false if the queue filled up first
+    bool pushBuffered(Connection& c) {
+        uint64_t records = 0;
+        bool complete = true;
+        while (c.end - c.begin >= sizeof(TelemetryRecord)) {
+            TelemetryRecord record;
+            std::memcpy(&record, c.buffer.data() + c.begin, sizeof(record));
+            if (!queue.tryPush(record)) {
+                complete = false;
+                break;
+            }
+            c.begin += sizeof(record);
+            ++records;
+        }
+        tcp_records.fetch_add(records, std::memory_order_relaxed);
+        noteDepth();
+        return complete;
+    }
+
+    // A paused connection isn't read until its buffer drains. The kernel
+    // still reports HUP/ERR for it, so a hung-up one leaves the epoll set.
+    void pause(Connection& c) {
+        if (c.hung_up) {
+            unwatch(c);
+        } else {
+            watch(c.fd, 0, EPOLL_CTL_MOD);
+        }
+        c.paused = true;
+        paused.push_back(&c);
+        tcp_pauses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void unwatch(Connection& c) {
+        if (!c.watched) return;
+        check(::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.fd, nullptr), "epoll_ctl");
+        c.watched = false;
+    }
+
+    // Every whole record is queued by now; a trailing partial one is rejected
+    void finish(Connection& c) {
+        bytes_rejected.fetch_add(c.end - c.begin, std::memory_order_relaxed);
+        closeConnection(c);
+    }
+
+    void readConnection(Connection& c) {
+        if (c.begin > 0) {
+            std::memmove(c.buffer.data(), c.buffer.data() + c.begin, c.end - c.begin);
+            c.end -= c.begin;
+            c.begin = 0;
+        }
+        if (c.end < c.buffer.size()) {
+            ssize_t n = ::read(c.fd, c.buffer.data() + c.end, c.buffer.size() - c.end);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) c.hung_up = true;
+            if (n > 0) c.end += static_cast<size_t>(n);
+        }
+        if (!pushBuffered(c)) {
+            pause(c);
+            return;
+        }
+        if (c.hung_up) finish(c);
+    }
+
+    void resumePaused() {
+        if (paused.empty() || queue.sizeApprox() > queue.capacity() / 2) return;
+        std::vector<Connection*> waiting;
+        waiting.swap(paused);
+        for (Connection* c : waiting) {
+            c->paused = false;
+            if (!pushBuffered(*c)) {
+                c->paused = true;
+                paused.push_back(c);
+                continue;
+            }
+            if (c->hung_up) {
+                finish(*c);
+                continue;
+            }
+            // Back in the set, a peer that hung up while paused reads out as EOF or an error
+            watch(c->fd, EPOLLIN | EPOLLRDHUP, c->watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD);
+            c->watched = true;
+        }
+    }
+
+    void eventLoop() {
+        std::array<epoll_event, MAX_EVENTS> events;
+        while (running.load(std::memory_order_acquire)) {
+            int n = ::epoll_wait(epoll_fd, events.data(), MAX_EVENTS, paused.empty() ? -1 : 1);
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == wake_fd) {
+                    uint64_t value;
+                    [[maybe_unused]] ssize_t r = ::read(wake_fd, &value, sizeof(value));
+                } else if (fd == udp_fd) {
+                    receiveDatagrams();
+                } else if (fd == listen_fd) {
+                    acceptConnections();
+                } else if (auto it = connections.find(fd); it != connections.end()) {
+                    Connection& c = *it->second;
+                    if (c.paused) {
+                        unwatch(c); // HUP/ERR; rechecked when it resumes
+                    } else {
+                        readConnection(c);
+                    }
+                }
+            }
+            resumePaused();
+        }
+        // Bytes that never reached the queue
+        for (const auto& [fd, connection] : connections) {
+            bytes_rejected.fetch_add(connection->end - connection->begin, std::memory_order_relaxed);
+        }
+    }
+
+    void consume() {
+        std::vector<SolarReading> batch;
+        batch.reserve(STORE_BATCH);
+        TelemetryRecord record;
+        while (true) {
+            while (batch.size() < STORE_BATCH && queue.tryPop(record)) batch.push_back(fromRecord(record));
+            if (!batch.empty()) {
+                optimizer.submitReadings(batch);
+                stored.fetch_add(batch.size(), std::memory_order_relaxed);
+                batches.fetch_add(1, std::memory_order_relaxed);
+                batch.clear();
+                if (after_batch) after_batch();
+                continue;
+            }
+            if (!running.load(std::memory_order_acquire) && queue.sizeApprox() == 0) {
+                optimizer.flushReorderBuffer();
+                if (after_batch) after_batch();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+public:
+    // Binds UDP and TCP on port; on_batch runs on the consumer thread after each stored batch
+    IngestServer(SolarOptimizer& target, uint16_t port, std::function<void()> on_batch = {},
+                 size_t queue_capacity = 1 << 16)
+        : optimizer(target), after_batch(std::move(on_batch)), queue(queue_capacity),
+          udp_storage(UDP_MESSAGES * UDP_BUFFER) {
+        try {
+            epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            check(epoll_fd, "epoll_create1");
+            wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            check(wake_fd, "eventfd");
+            udp_fd = bindSocket(SOCK_DGRAM, port);
+            int receive_buffer = 8 << 20;
+            ::setsockopt(udp_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+            listen_fd = bindSocket(SOCK_STREAM, port);
+            check(::listen(listen_fd, 128), "listen");
+            watch(wake_fd, EPOLLIN);
+            watch(udp_fd, EPOLLIN);
+            watch(listen_fd, EPOLLIN);
+        } catch (...) {
+            closeAll();
+            throw;
+        }
+        for (size_t i = 0; i < UDP_MESSAGES; ++i) {
+            vectors[i].iov_base = udp_storage.data() + i * UDP_BUFFER;
+            vectors[i].iov_len = UDP_BUFFER;
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    ~IngestServer() {
+        stop();
+        closeAll();
+    }
+
+    IngestServer(const IngestServer&) = delete;
+    IngestServer& operator=(const IngestServer&) = delete;
+
+    void start() {
+        if (running.exchange(true)) return;
+        consumer_thread = std::thread([this] { consume(); });
+        loop_thread = std::thread([this] { eventLoop(); });
+    }
+
+    // Stops receiving, then stores everything already queued before returning
+    void stop() {
+        if (!running.exchange(false)) return;
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = ::write(wake_fd, &one, sizeof(one));
+        loop_thread.join();
+        consumer_thread.join();
+    }
+
+    IngestStats stats() const {
+        IngestStats s;
+        s.datagrams = datagrams.load(std::memory_order_relaxed);
+        s.udp_records = udp_records.load(std::memory_order_relaxed);
+        s.tcp_records = tcp_records.load(std::memory_order_relaxed);
+        s.bytes_rejected = bytes_rejected.load(std::memory_order_relaxed);
+        s.udp_dropped = udp_dropped.load(std::memory_order_relaxed);
+        s.tcp_pauses = tcp_pauses.load(std::memory_order_relaxed);
+        s.connections = accepted.load(std::memory_order_relaxed);
+        s.stored = stored.load(std::memory_order_relaxed);
+        s.batches = batches.load(std::memory_order_relaxed);
+        s.queue_depth = queue.sizeApprox();
+        s.queue_high_water = high_water.load(std::memory_order_relaxed);
+        s.queue_capacity = queue.capacity();
+        return s;
+    }
+
+private:
+    void closeAll() {
+        for (auto& [fd, connection] : connections) ::close(fd);
+        connections.clear();
+        paused.clear();
+        for (int* fd : {&listen_fd, &udp_fd, &wake_fd, &epoll_fd}) {
+            if (*fd >= 0) ::close(*fd);
+            *fd = -1;
+        }
+    }
+};
+
+inline void printIngestStats(std::ostream& os, const IngestStats& s) {
+    os << "udp " << s.udp_records << " records / " << s.datagrams << " datagrams, "
+       << "tcp " << s.tcp_records << " records / " << s.connections << " connections, "
+       << "stored " << s.stored << " in " << s.batches << " batches, "
+       << "dropped " << s.udp_dropped << ", tcp pauses " << s.tcp_pauses
+       << ", rejected bytes " << s.bytes_rejected << ", queue " << s.queue_depth << "/" << s.queue_capacity
+       << " (peak " << s.queue_high_water << ")\n";
+}
+#endif
+
+// Allocation accounting for --bench, compiled in with
+// -DSOLAR_BENCH_ALLOCATIONS=1. It replaces the global allocation functions
+// (every form, so array and aligned allocations count too) with ones that
+// bump a thread-local counter; otherwise the standard allocator is left
+// alone and the allocs/call column reads "-".
+#ifndef SOLAR_BENCH_ALLOCATIONS
+#define SOLAR_BENCH_ALLOCATIONS 0
+#endif
+
+#if SOLAR_BENCH_ALLOCATIONS
+thread_local uint64_t thread_allocations = 0;
+
+// All out of line so GCC doesn't pair an inlined malloc() or free() with
+// the other side and warn about mismatched allocation functions
+[[gnu::noinline]] void* countedAllocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept {
+    ++thread_allocations;
+    size = size ? size : 1;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] void* countedAllocateOrThrow(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    if (void* p = countedAllocate(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size) { return countedAllocateOrThrow(size); }
+[[gnu::noinline]] void* operator new[](std::size_t size) { return countedAllocateOrThrow(size); }
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t a) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(a));
+}
+[[gnu::noinline]] void* operator new[](std::size_t size, std::align_val_t a) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(a));
+}
+[[gnu::noinline]] void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+[[gnu::noinline]] void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(a));
+}
+[[gnu::noinline]] void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(a));
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+inline uint64_t allocationCount() { return thread_allocations; }
+#else
+inline uint64_t allocationCount() { return 0; }
+#endif
+
+// Deterministic synthetic telemetry at a fixed cadence: a diurnal irradiance
+// curve with noise, panel temperature following the sun, ~80% efficiency.
+class SyntheticTelemetry {
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> noise{-1.0, 1.0};
+    time_t next_timestamp;
+    time_t step;
+    double soc = 50.0;
+
+    // Injected faults, off unless set
+    time_t degradation_start = std::numeric_limits<time_t>::max();
+    double degradation_per_day = 0.0;
+    time_t heat_start = 0;
+    time_t heat_end = 0;
+    double heat_celsius = 0.0;
+
+public:
+    explicit SyntheticTelemetry(uint64_t seed = 42, time_t start = 1700000000, time_t step_seconds = 1)
+        : rng(seed), next_timestamp(start), step(step_seconds) {}
+
+    // From start on, output falls linearly by fraction_per_day of its healthy value
+    void injectDegradation(time_t start, double fraction_per_day) {
+        degradation_start = start;
+        degradation_per_day = fraction_per_day;
+    }
+
+    // Panels run extra_celsius hotter during [start, start + duration)
+    void injectHeatEvent(time_t start, time_t duration, double extra_celsius) {
+        heat_start = start;
+        heat_end = start + duration;
+        heat_celsius = extra_celsius;
+    }
+
+    SolarReading next() {
+        time_t ts = next_timestamp;
+        next_timestamp += step;
+        double day_fraction = static_cast<double>(ts % 86400) / 86400.0;
+        double sun = std::max(0.0, std::sin((day_fraction - 0.25) * 2.0 * M_PI));
+        double irradiance = std::max(0.0, 1000.0 * sun * (0.85 + 0.15 * noise(rng)));
+        double produced = irradiance / 1000.0 * 300.0 * (0.8 + 0.02 * noise(rng));
+        if (ts >= degradation_start) {
+            produced *= std::max(0.0, 1.0 - degradation_per_day * static_cast<double>(ts - degradation_start) / 86400.0);
+        }
+        double consumed = 150.0 + 50.0 * noise(rng);
+        // 5 kWh battery absorbs the surplus or covers the deficit
+        soc = std::clamp(soc + (produced - consumed) * static_cast<double>(step) / 3600.0 / 5000.0 * 100.0, 0.0, 100.0);
+        double temperature = 20.0 + 45.0 * sun + 3.0 * noise(rng);
+        if (ts >= heat_start && ts < heat_end) temperature += heat_celsius;
+        double voltage = irradiance > 0 ? 36.0 + noise(rng) : 0.0;
+        double current = voltage > 0 ? produced / 0.96 / voltage : 0.0;
+        return SolarReading(ts, produced, consumed, soc, irradiance, temperature, voltage, current);
+    }
+};
+
+// Times every stride-th call so run length doesn't bound memory
+class LatencySampler {
+    std::vector<double> samples_ns;
+    size_t stride;
+
+public:
+    explicit LatencySampler(size_t calls, size_t max_samples = 1 << 20)
+        : stride(std::max<size_t>(1, calls / max_samples)) {
+        samples_ns.reserve(std::min(calls, max_samples) + 1);
+    }
+
+    bool shouldSample(size_t call) const { return call % stride == 0; }
+    void record(std::chrono::steady_clock::duration d) {
+        samples_ns.push_back(std::chrono::duration<double, std::nano>(d).count());
+    }
+
+    double percentile(double p) {
+        if (samples_ns.empty()) return 0.0;
+        size_t k = std::min(samples_ns.size() - 1, static_cast<size_t>(p * static_cast<double>(samples_ns.size())));
+        std::nth_element(samples_ns.begin(), samples_ns.begin() + static_cast<std::ptrdiff_t>(k), samples_ns.end());
+        return samples_ns[k];
+    }
+};
+
+// Results are written here so the optimizer can't discard the measured work
+volatile double bench_sink = 0.0;
+
+struct BenchResult {
+    double seconds = std::numeric_limits<double>::max(); // fastest repetition
+    uint64_t allocations = 0;                             // of the fastest repetition
+};
+
+void printBenchResult(const std::string& name, size_t n, uint64_t ops, const BenchResult& result,
+                      LatencySampler& latency) {
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(11) << n
+              << std::setw(14) << std::fixed << std::setprecision(0) << ops / result.seconds
+              << std::setw(10) << std::setprecision(1) << latency.percentile(0.50)
+              << std::setw(10) << latency.percentile(0.99)
+              << std::setw(10) << latency.percentile(0.999)
+              << std::setw(12) << std::setprecision(4);
+    if (SOLAR_BENCH_ALLOCATIONS) {
+        std::cout << static_cast<double>(result.allocations) / static_cast<double>(ops);
+    } else {
+        std::cout << "-";
+    }
+    std::cout << "\n" << std::defaultfloat;
+}
+
+// Feeds `n` synthetic readings through `op` in chunks; only `op` is timed
+template <typename Op>
+void timeReadings(size_t n, size_t chunk, BenchResult& result, LatencySampler& latency, Op op) {
+    using clock = std::chrono::steady_clock;
+    SyntheticTelemetry telemetry;
+    std::vector<SolarReading> readings;
+    readings.reserve(chunk);
+    clock::duration elapsed{};
+    uint64_t allocations = 0;
+    for (size_t done = 0; done < n; done += readings.size()) {
+        readings.clear();
+        for (size_t i = 0; i < std::min(chunk, n - done); ++i) readings.push_back(telemetry.next());
+
+        uint64_t allocs_before = allocationCount();
+        auto start = clock::now();
+        op(std::span<const SolarReading>(readings), done, latency);
+        elapsed += clock::now() - start;
+        allocations += allocationCount() - allocs_before;
+    }
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    if (seconds < result.seconds) {
+        result.seconds = seconds;
+        result.allocations = allocations;
+    }
+}
+
+// Per-call variant: samples the latency of individual calls inside the chunk
+template <typename Call>
+void timeEachReading(size_t n, BenchResult& result, LatencySampler& latency, Call call) {
+    timeReadings(n, 4096, result, latency,
+                 [&](std::span<const SolarReading> readings, size_t first, LatencySampler& sampler) {
+                     for (size_t i = 0; i < readings.size(); ++i) {
+                         if (sampler.shouldSample(first + i)) {
+                             auto start = std::chrono::steady_clock::now();
+                             call(readings[i]);
+                             sampler.record(std::chrono::steady_clock::now() - start);
+                         } else {
+                             call(readings[i]);
+                         }
+                     }
+                 });
+}
+
+template <typename DB>
+void benchGetReadings(const std::string& name, size_t n, int reps) {
+    DB db;
+    SyntheticTelemetry telemetry;
+    for (size_t i = 0; i < n; ++i) db.storeReading(telemetry.next());
+
+    // One-hour windows at deterministic offsets; fewer queries on bigger stores
+    size_t queries = std::clamp<size_t>(10000000 / std::max<size_t>(n, 1), 10, 10000);
+    size_t checksum = 0;
+    // Fresh result vectors, then one caller-owned buffer reused across queries
+    for (bool reuse : {false, true}) {
+        LatencySampler latency(queries * static_cast<size_t>(reps));
+        BenchResult result;
+        std::vector<SolarReading> buffer;
+        for (int rep = 0; rep < reps; ++rep) {
+            std::mt19937_64 rng(7);
+            auto span = static_cast<time_t>(n);
+            uint64_t allocs_before = allocationCount();
+            std::chrono::steady_clock::duration elapsed{};
+            for (size_t q = 0; q < queries; ++q) {
+                time_t start = 1700000000 + static_cast<time_t>(rng() % static_cast<uint64_t>(span));
+                auto t0 = std::chrono::steady_clock::now();
+                checksum += reuse ? db.getReadings(start, start + 3599, buffer)
+                                  : db.getReadings(start, start + 3599).size();
+                auto d = std::chrono::steady_clock::now() - t0;
+                elapsed += d;
+                latency.record(d);
+            }
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            if (seconds < result.seconds) {
+                result.seconds = seconds;
+                result.allocations = allocationCount() - allocs_before;
+            }
+        }
+        printBenchResult(name + (reuse ? " (1h, buffer)" : " (1h)"), n, queries, result, latency);
+    }
+    bench_sink = static_cast<double>(checksum);
+}
+
+// Scalar vs dispatched efficiency kernel over n-element columns; throughput
+// is in elements/s and latency per kernel call
+void benchEfficiencyKernel(size_t n, int reps) {
+    SyntheticTelemetry telemetry;
+    std::vector<double> irradiance(n), power(n), efficiency(n);
+    for (size_t i = 0; i < n; ++i) {
+        SolarReading reading = telemetry.next();
+        irradiance[i] = reading.irradiance;
+        power[i] = reading.power_produced;
+    }
+    const BatchKernels& dispatched = BatchKernels::get();
+    const size_t calls = std::max<size_t>(1, 10000000 / std::max<size_t>(n, 1));
+    for (auto kernel : {BatchKernels::efficiencyScalar, dispatched.efficiency}) {
+        BenchResult result;
+        LatencySampler latency(calls * static_cast<size_t>(reps));
+        for (int rep = 0; rep < reps; ++rep) {
+            uint64_t allocs_before = allocationCount();
+            std::chrono::steady_clock::duration elapsed{};
+            for (size_t call = 0; call < calls; ++call) {
+                auto start = std::chrono::steady_clock::now();
+                kernel(irradiance.data(), power.data(), 300.0, efficiency.data(), n);
+                auto d = std::chrono::steady_clock::now() - start;
+                latency.record(d);
+                elapsed += d;
+            }
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            if (seconds < result.seconds) {
+                result.seconds = seconds;
+                result.allocations = allocationCount() - allocs_before;
+            }
+        }
+        bench_sink = efficiency[n / 2];
+        std::string isa = kernel == BatchKernels::efficiencyScalar ? "scalar" : dispatched.isa;
+        printBenchResult("efficiency kernel (" + isa + ")", n, n * calls, result, latency);
+    }
+}
+
+// Drives the ingest and maintenance-check paths with synthetic telemetry at
+// sizes 1e3 .. max_readings. Columns: throughput in calls/s, per-call latency
+// percentiles in ns, heap allocations per call.
+void runBenchmarks(size_t max_readings, int reps) {
+    Logger::instance().setLevel(LogLevel::Warning);
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right << std::setw(11) << "n"
+              << std::setw(14) << "calls/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+              << std::setw(10) << "p99.9 ns" << std::setw(12) << "allocs/call" << "\n";
+
+    for (size_t n = 1000; n <= max_readings; n *= 10) {
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            for (int rep = 0; rep < reps; ++rep) {
+                SolarOptimizer optimizer(std::make_unique<ColumnarDB>());
+                timeEachReading(n, result, latency, [&](const SolarReading& r) { optimizer.storeReading(r); });
+            }
+            printBenchResult("storeReading", n, n, result, latency);
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps) / 4096 + 1);
+            for (int rep = 0; rep < reps; ++rep) {
+                SolarOptimizer optimizer(std::make_unique<ColumnarDB>());
+                timeReadings(n, 4096, result, latency,
+                             [&](std::span<const SolarReading> batch, size_t, LatencySampler& sampler) {
+                                 auto start = std::chrono::steady_clock::now();
+                                 optimizer.storeReadings(batch);
+                                 sampler.record(std::chrono::steady_clock::now() - start);
+                             });
+            }
+            printBenchResult("storeReadings (x4096)", n, n, result, latency);
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps) / 4096 + 1);
+            for (int rep = 0; rep < reps; ++rep) {
+                SolarOptimizer optimizer(std::make_unique<ColumnarDB>());
+                timeReadings(n, 4096, result, latency,
+                             [&](std::span<const SolarReading> batch, size_t, LatencySampler& sampler) {
+                                 auto start = std::chrono::steady_clock::now();
+                                 optimizer.submitReadings(batch);
+                                 sampler.record(std::chrono::steady_clock::now() - start);
+                             });
+            }
+            printBenchResult("submitReadings (x4096)", n, n, result, latency);
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            for (int rep = 0; rep < reps; ++rep) {
+                SolarOptimizer optimizer(std::make_unique<MockDB>());
+                timeEachReading(n, result, latency,
+                                [&](const SolarReading& r) { optimizer.performMaintenanceChecks(r); });
+            }
+            printBenchResult("performMaintenanceChecks", n, n, result, latency);
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            EnvironmentalImpact impact;
+            for (int rep = 0; rep < reps; ++rep) {
+                timeEachReading(n, result, latency, [&](const SolarReading& r) { impact.addEnergy(r.power_produced, 1.0); });
+            }
+            printBenchResult("addEnergy", n, n, result, latency);
+            bench_sink = impact.getTotalEnergy();
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            EnvironmentalImpact impact;
+            for (int rep = 0; rep < reps; ++rep) {
+                timeEachReading(n, result, latency, [&](const SolarReading& r) {
+                    impact.addSample(0, r.timestamp, r.power_produced);
+                });
+            }
+            printBenchResult("addSample", n, n, result, latency);
+            bench_sink = impact.getTotalEnergy();
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            std::vector<Load> loads;
+            for (size_t i = 0; i < MAX_LOADS; ++i) {
+                loads.emplace_back("load" + std::to_string(i), 50.0 * static_cast<double>(i + 1), static_cast<int>(i % 3) + 1);
+            }
+            LoadScheduler scheduler(std::move(loads));
+            uint32_t enabled = 0;
+            for (int rep = 0; rep < reps; ++rep) {
+                timeEachReading(n, result, latency, [&](const SolarReading& r) {
+                    enabled ^= scheduler.decide(r.power_produced, r.battery_soc).enabled;
+                });
+            }
+            printBenchResult("LoadScheduler::decide", n, n, result, latency);
+            bench_sink = enabled;
+        }
+        {
+            BenchResult result;
+            LatencySampler latency(n * static_cast<size_t>(reps));
+            ProductionForecaster forecaster;
+            std::array<double, 96> day_ahead{};
+            for (int rep = 0; rep < reps; ++rep) {
+                timeEachReading(n, result, latency, [&](const SolarReading& r) {
+                    forecaster.update(r, 300.0);
+                    forecaster.forecast(r.timestamp, 900, 300.0, day_ahead);
+                });
+            }
+            printBenchResult("forecast update+96 steps", n, n, result, latency);
+            bench_sink = day_ahead[0];
+        }
+        benchEfficiencyKernel(n, reps);
+        benchGetReadings<MockDB>("MockDB::getReadings", n, reps);
+        benchGetReadings<ColumnarDB>("ColumnarDB::getReadings", n, reps);
+        benchGetReadings<CompactDB>("CompactDB::getReadings", n, reps);
+        benchGetReadings<TieredDB>("TieredDB::getReadings", n, reps);
+        if (n > max_readings / 10) break;
+    }
+}
+
+// The large stores of an optimizer as of its latest snapshot, kept in step
+// by applying each snapshot's changes; serializes a full checkpoint off the
+// ingest thread. Costs a second copy of the rollups, sketches and power history.
+class CheckpointMirror {
+    RollupStore rollups;
+    QuantileStore quantiles;
+    PowerHistory power_history;
+
+public:
+    void apply(CheckpointSnapshot&& snapshot) {
+        rollups.applyChanges(std::move(snapshot.rollups));
+        quantiles.applyChanges(std::move(snapshot.quantiles));
+        power_history.applyChanges(std::move(snapshot.power_history));
+    }
+
+    // Checkpoint bytes for the small state of the last snapshot applied
+    std::string checkpoint(std::string state) const {
+        CheckpointWriter out;
+        out.buffer() = std::move(state);
+        rollups.save(out);
+        quantiles.save(out);
+        power_history.save(out);
+        return std::move(out.buffer());
+    }
+};
+
+// Periodic checkpoints of an optimizer's derived state. The ingest thread
+// only takes a snapshot: the small state plus what changed in the large
+// stores since the last one, typically a few buckets. A background thread
+// applies snapshots to a CheckpointMirror, serializes it and does the file
+// write and fdatasync. Snapshots taken while a write runs queue up (each
+// carries changes the next one builds on) and go out as one write.
+class Checkpointer {
+    std::string path;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point last_taken = std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<CheckpointSnapshot> pending;
+    bool writing = false;
+    bool stopping = false;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    CheckpointMirror mirror; // writer thread only
+    std::thread writer;
+
+    void writeLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<CheckpointSnapshot> batch;
+        for (;;) {
+            wake.wait(lock, [&] { return !pending.empty() || stopping; });
+            if (pending.empty()) return;
+            batch.swap(pending);
+            writing = true;
+            lock.unlock();
+            std::string state = std::move(batch.back().state);
+            for (auto& snapshot : batch) mirror.apply(std::move(snapshot));
+            batch.clear();
+            const bool ok = writeFileAtomically(path, mirror.checkpoint(std::move(state)));
+            if (!ok) std::cerr << "Cannot write checkpoint " << path << ": " << std::strerror(errno) << "\n";
+            lock.lock();
+            writing = false;
+            ++(ok ? written : failed);
+            idle.notify_all();
+        }
+    }
+
+public:
+    Checkpointer(std::string file, time_t interval_seconds)
+        : path(std::move(file)), interval(std::chrono::seconds(interval_seconds)),
+          writer([this] { writeLoop(); }) {}
+
+    ~Checkpointer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+
+    // Restore optimizer from the checkpoint file, if there is one; returns
+    // whether it was restored and sets position to the database position it covers
+    bool restore(SolarOptimizer& optimizer, uint64_t& position) const {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (file.bad()) throw std::runtime_error("Cannot read checkpoint " + path);
+        try {
+            position = optimizer.restore(bytes);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(path + ": " + e.what());
+        }
+        return true;
+    }
+
+    // Checkpoint if the interval has passed since the last one
+    void maybeCheckpoint(SolarOptimizer& optimizer) {
+        if (std::chrono::steady_clock::now() - last_taken < interval) return;
+        checkpoint(optimizer);
+    }
+
+    // Every checkpoint of an optimizer must go through the same Checkpointer:
+    // each snapshot only carries changes since the one before
+    void checkpoint(SolarOptimizer& optimizer) {
+        CheckpointSnapshot snapshot = optimizer.snapshot();
+        last_taken = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(snapshot));
+        }
+        wake.notify_one();
+    }
+
+    // Wait until every checkpoint taken so far is on disk (or failed)
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&] { return pending.empty() && !writing; });
+    }
+
+    uint64_t writtenCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return written;
+    }
+
+    uint64_t failedCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+};
+
+void runInteractive(SolarOptimizer& optimizer) {
+    int num_readings;
+    std::cout << "Enter the number of solar readings: ";
+    std::cin >> num_readings;
+
+    for (int i = 0; i < num_readings; ++i) {
+        double prod, cons, soc, irr, temp, volt, curr;
+        std::cout << "\nEnter data for Reading #" << (i + 1) << ":\n";
+
+        std::cout << "Power Produced (W): ";
+        std::cin >> prod;
+        std::cout << "Power Consumed (W): ";
+        std::cin >> cons;
+        std::cout << "Battery SOC (%): ";
+        std::cin >> soc;
+        std::cout << "Irradiance (W/m^2): ";
+        std::cin >> irr;
+        std::cout << "Temperature (°C): ";
+        std::cin >> temp;
+        std::cout << "Panel Voltage (V): ";
+        std::cin >> volt;
+        std::cout << "Panel Current (A): ";
+        std::cin >> curr;
+
+        SolarReading reading(prod, cons, soc, irr, temp, volt, curr);
+        optimizer.storeReading(reading);
+        Logger::instance().flush(); // keep log lines in step with the prompts
+    }
+}
+
+// p5/p50/p95 of panel efficiency and temperature from a window's sketches
+void printPercentiles(std::ostream& os, const QuantileSketches& sketches) {
+    os << "\n=== PERCENTILES (p5 / p50 / p95) ===\n" << std::fixed << std::setprecision(1);
+    if (sketches.efficiency.count() > 0) {
+        os << "Panel efficiency (%): " << sketches.efficiency.quantile(0.05) * 100 << " / "
+           << sketches.efficiency.quantile(0.5) * 100 << " / " << sketches.efficiency.quantile(0.95) * 100 << "\n";
+    }
+    if (sketches.temperature.count() > 0) {
+        os << "Temperature (°C): " << sketches.temperature.quantile(0.05) << " / "
+           << sketches.temperature.quantile(0.5) << " / " << sketches.temperature.quantile(0.95) << "\n";
+    }
+    os << std::defaultfloat << std::setprecision(6);
+}
+
+void printLateReadingStats(std::ostream& os, const LateReadingStats& stats) {
+    if (stats.corrected + stats.uncorrected + stats.duplicates == 0) return;
+    os << "Late readings: " << stats.corrected << " corrected, " << stats.uncorrected
+       << " beyond the correction horizon, " << stats.duplicates << " duplicates dropped\n";
+}
+
+// Non-interactive ingest of a CSV or binary telemetry stream
+bool runIngest(SolarOptimizer& optimizer, const std::string& path, TelemetryFormat format,
+               DashboardWriter* dashboard = nullptr, Checkpointer* checkpointer = nullptr) {
+    TelemetryReader reader(path, format);
+    if (!reader.isOpen()) {
+        std::cerr << "Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    constexpr size_t BATCH_SIZE = 4096;
+    std::vector<SolarReading> batch;
+    batch.reserve(BATCH_SIZE);
+
+    auto started = std::chrono::steady_clock::now();
+    while (reader.readBatch(batch, BATCH_SIZE)) {
+        optimizer.submitReadings(batch);
+        if (dashboard) dashboard->update(optimizer.rollupStore());
+        if (checkpointer) checkpointer->maybeCheckpoint(optimizer);
+    }
+    optimizer.flushReorderBuffer();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::cerr << "Ingested " << reader.rowsRead() << " readings (" << reader.rowsRejected()
+              << " rejected) in " << seconds << " s";
+    if (seconds > 0) std::cerr << " (" << static_cast<uint64_t>(reader.rowsRead() / seconds) << " readings/s)";
+    std::cerr << "\n";
+    printLateReadingStats(std::cerr, optimizer.lateReadingStats());
+    return true;
+}
+
+// Resident set size of this process; 0 where /proc isn't available
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+struct SimulationOptions {
+    size_t sites = 100;
+    double days = 7.0;           // simulated time span
+    time_t step = 60;            // seconds between a site's readings
+    double rate = 0.0;           // readings/s fed to the fleet; 0 = as fast as possible
+    size_t workers = 0;          // 0 = one per core
+    FleetOptimizer::DatabaseFactory make_db = [](uint32_t) { return std::make_unique<ColumnarDB>(); };
+};
+
+// Load test: deterministic telemetry for a fleet, fed through
+// FleetOptimizer::submit() in simulated-time order. Every 10th site
+// degrades by 2 %/day from day 2 and every 7th has a two-hour +20 °C heat
+// event at noon on day 3, so the checks have something to find. Reports
+// throughput, ingest lag (time until the fleet has processed everything
+// submitted at a sampled instant) and resident memory every 5 s and at the end.
+void runSimulation(const SimulationOptions& options) {
+    constexpr time_t START = 1700000000 - 1700000000 % 86400; // midnight UTC
+    const size_t sites = std::max<size_t>(1, options.sites);
+    const time_t step = std::max<time_t>(1, options.step);
+    const auto steps = static_cast<uint64_t>(options.days * 86400.0 / static_cast<double>(step));
+    const uint64_t total = steps * sites;
+
+    // Every 10th site loses 2%/day from day 2; every 7th runs 20 °C hot for
+    // two hours from noon on day 3
+    constexpr time_t DEGRADE_FROM = START + 2 * 86400;
+    constexpr time_t HEAT_FROM = START + 3 * 86400 + 12 * 3600;
+    const time_t end = START + static_cast<time_t>(steps) * step;
+    size_t degrading = 0;
+    size_t heated = 0;
+    std::vector<SyntheticTelemetry> telemetry;
+    telemetry.reserve(sites);
+    for (size_t i = 0; i < sites; ++i) {
+        telemetry.emplace_back(i + 1, START, step);
+        if (i % 10 == 9) {
+            telemetry.back().injectDegradation(DEGRADE_FROM, 0.02);
+            degrading += DEGRADE_FROM < end;
+        }
+        if (i % 7 == 6) {
+            telemetry.back().injectHeatEvent(HEAT_FROM, 2 * 3600, 20.0);
+            heated += HEAT_FROM < end;
+        }
+    }
+
+    const size_t workers = options.workers > 0 ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+    const size_t rss_start = residentBytes();
+    FleetOptimizer fleet(workers, options.make_db);
+    std::cerr << "Simulating " << sites << " sites for " << options.days << " days at " << step
+              << " s intervals (" << total << " readings) on " << fleet.workerCount() << " worker threads\n";
+
+    struct Probe {
+        std::chrono::steady_clock::time_point at;
+        uint64_t submitted;
+    };
+    constexpr uint64_t PROBE_EVERY = 4096;
+    std::deque<Probe> probes;
+    LatencySampler lag(total / PROBE_EVERY + 1);
+    LatencySampler window_lag(total / PROBE_EVERY + 1);
+    auto checkProbes = [&](std::chrono::steady_clock::time_point now) {
+        const uint64_t processed = fleet.processedCount();
+        while (!probes.empty() && probes.front().submitted <= processed) {
+            lag.record(now - probes.front().at);
+            window_lag.record(now - probes.front().at);
+            probes.pop_front();
+        }
+    };
+
+    const auto started = std::chrono::steady_clock::now();
+    auto last_report = started;
+    uint64_t last_count = 0;
+    uint64_t submitted = 0;
+    auto report = [&](std::chrono::steady_clock::time_point now) {
+        const double elapsed = std::chrono::duration<double>(now - started).count();
+        const double window = std::chrono::duration<double>(now - last_report).count();
+        std::cerr << std::fixed << std::setprecision(1) << "  t=" << elapsed << " s: " << submitted << " readings, "
+                  << static_cast<double>(submitted - last_count) / std::max(window, 1e-9) << " readings/s, lag p50 "
+                  << window_lag.percentile(0.5) / 1e6 << " ms p99 " << window_lag.percentile(0.99) / 1e6
+                  << " ms, RSS " << static_cast<double>(residentBytes()) / 1e6 << " MB\n"
+                  << std::defaultfloat << std::setprecision(6);
+        window_lag = LatencySampler(total / PROBE_EVERY + 1);
+        last_report = now;
+        last_count = submitted;
+    };
+
+    for (uint64_t t = 0; t < steps; ++t) {
+        for (size_t site = 0; site < sites; ++site) {
+            fleet.submit(static_cast<uint32_t>(site), telemetry[site].next());
+            if (++submitted % PROBE_EVERY != 0) continue;
+
+            auto now = std::chrono::steady_clock::now();
+            probes.push_back({now, submitted});
+            checkProbes(now);
+            if (options.rate > 0) {
+                // Pace to the requested rate against the start, so short stalls are made up
+                auto due = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                         std::chrono::duration<double>(static_cast<double>(submitted) / options.rate));
+                if (due > now) std::this_thread::sleep_until(due);
+            }
+            if (now - last_report >= std::chrono::seconds(5)) report(now);
+        }
+    }
+    while (fleet.processedCount() < submitted) {
+        checkProbes(std::chrono::steady_clock::now());
+        std::this_thread::yield();
+    }
+    checkProbes(std::chrono::steady_clock::now());
+    fleet.drain();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const size_t rss_end = residentBytes();
+
+    std::cout << "\n=== SIMULATION ===\n"
+              << "Readings: " << submitted << " from " << sites << " sites in " << seconds << " s\n"
+              << "Sustained throughput: " << static_cast<uint64_t>(static_cast<double>(submitted) / seconds)
+              << " readings/s (" << static_cast<double>(steps * static_cast<uint64_t>(step)) / seconds
+              << "x real time)\n"
+              << "Ingest lag: p50 " << lag.percentile(0.5) / 1e6 << " ms, p99 " << lag.percentile(0.99) / 1e6
+              << " ms, p99.9 " << lag.percentile(0.999) / 1e6 << " ms\n"
+              << "Resident memory: " << rss_start / 1000000 << " MB -> " << rss_end / 1000000 << " MB ("
+              << static_cast<double>(rss_end - std::min(rss_start, rss_end)) / static_cast<double>(sites) / 1000.0
+              << " kB per site, "
+              << static_cast<double>(rss_end - std::min(rss_start, rss_end)) / std::max<double>(1.0, static_cast<double>(submitted))
+              << " B per reading)\n";
+
+    std::map<AlertType, size_t> by_type;
+    for (const auto& alert : fleet.fleetAlerts()) ++by_type[alert.type];
+    std::cout << "Active alerts:";
+    if (by_type.empty()) std::cout << " none";
+    for (const auto& [type, count] : by_type) {
+        std::cout << (type == by_type.begin()->first ? " " : ", ") << count << " " << alertTypeName(type);
+    }
+    std::cout << "\n";
+    std::cout << "Injected faults: " << degrading << " degrading sites, " << heated << " heat events\n";
+    printPercentiles(std::cout, fleet.fleetQuantiles(std::numeric_limits<time_t>::min(),
+                                                     std::numeric_limits<time_t>::max()));
+    fleet.fleetEnvironmentalImpact().generateReport();
+}
+
+// Metrics snapshot for Prometheus' textfile collector; a no-op without metrics
+void writeMetrics(const std::string& path) {
+#if SOLAR_ENABLE_METRICS
+    if (path.empty()) return;
+    std::ostringstream text;
+    Metrics::instance().writePrometheus(text);
+    if (!writeFileAtomically(path, text.view())) {
+        std::cerr << "Cannot write " << path << ": " << std::strerror(errno) << "\n";
+    }
+#else
+    (void)path;
+#endif
+}
+
+#ifdef __linux__
+volatile std::sig_atomic_t stop_requested = 0;
+
+// Serve network ingest until SIGINT or SIGTERM, printing stats (and
+// refreshing the metrics file) every 10 s
+bool runServer(SolarOptimizer& optimizer, uint16_t port, DashboardWriter* dashboard,
+               Checkpointer* checkpointer, const std::string& metrics_path) {
+    std::function<void()> on_batch;
+    time_t last_dashboard = 0;
+    if (dashboard || checkpointer) {
+        on_batch = [&] {
+            if (checkpointer) checkpointer->maybeCheckpoint(optimizer);
+            if (!dashboard) return;
+            time_t now = std::time(nullptr);
+            if (now == last_dashboard) return;
+            last_dashboard = now;
+            dashboard->update(optimizer.rollupStore());
+        };
+    }
+    std::unique_ptr<IngestServer> server;
+    try {
+        server = std::make_unique<IngestServer>(optimizer, port, std::move(on_batch));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return false;
+    }
+
+    struct sigaction action{};
+    action.sa_handler = [](int) { stop_requested = 1; };
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    std::cerr << "Listening for telemetry records on UDP and TCP port " << port << "\n";
+    server->start();
+    auto last_report = std::chrono::steady_clock::now();
+    while (!stop_requested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() - last_report >= std::chrono::seconds(10)) {
+            printIngestStats(std::cerr, server->stats());
+            writeMetrics(metrics_path);
+            last_report = std::chrono::steady_clock::now();
+        }
+    }
+    server->stop();
+    if (dashboard) dashboard->update(optimizer.rollupStore());
+    printIngestStats(std::cerr, server->stats());
+    return true;
+}
+#endif
+
+// Load the checkpoint, then replay the readings the database holds beyond it
+void restoreCheckpoint(SolarOptimizer& optimizer, const Checkpointer& checkpointer) {
+    uint64_t position = 0;
+    if (!checkpointer.restore(optimizer, position)) return;
+    const time_t covered_through = optimizer.latestTimestamp();
+    size_t replayed = optimizer.replayFromDatabase(position);
+    std::cerr << "Restored checkpoint through " << covered_through << ", replayed " << replayed
+              << " readings stored after it\n";
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--config FILE] [--db LOG | --compact | --tiered] [--write-behind] [--dashboard DIR]\n"
+              << "       " << std::string(std::strlen(program), ' ')
+              << " [--checkpoint FILE [--checkpoint-interval SECONDS]] [--csv FILE | --binary FILE]\n"
+              << "       " << program << " --bench [MAX_READINGS] [--reps N]\n"
+              << "       " << program << " --simulate SITES [--days N] [--step SECONDS] [--rate READINGS_PER_S]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--workers N] [--compact | --tiered]\n"
+#ifdef __linux__
+              << "       " << program << " --listen PORT [--config FILE] [--db LOG | --compact | --tiered] [--dashboard DIR]\n"
+#endif
+              << "  With no input option, readings are entered interactively.\n"
+              << "  FILE may be - to read from stdin.\n"
+              << "  --config loads site panel specs and thresholds (key = value lines).\n"
+              << "  --db keeps readings in a persistent append-only log.\n"
+              << "  --write-behind stores readings from a background writer with group commit.\n"
+              << "  --compact keeps ingested history quantized in memory (24 bytes per reading).\n"
+              << "  --tiered keeps the last day raw, 90 days Gorilla-compressed and older data as hourly means.\n"
+              << "  --dashboard DIR maintains DIR/dashboard.html with hourly charts of ingested data.\n"
+              << "  --percentiles prints p5/p50/p95 panel efficiency and temperature after ingest.\n"
+              << "  --checkpoint restores derived state from FILE at startup (replaying what\n"
+              << "    --db stored after it), saves it every SECONDS (default 300) during ingest and on exit.\n"
+#if SOLAR_ENABLE_METRICS
+              << "  --metrics FILE writes Prometheus text metrics on exit (and every 10 s with --listen).\n"
+#endif
+#ifdef __linux__
+              << "  --listen receives 64-byte binary records over UDP and TCP until interrupted.\n"
+#endif
+              << "  --bench runs the micro-benchmarks at 1e3 .. MAX_READINGS (default 1e6).\n"
+              << "  --simulate feeds synthetic telemetry for SITES sites through the fleet ingest path\n"
+              << "    (default 7 days at 60 s, unthrottled) and reports throughput, lag and memory.\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string ingest_path;
+    std::string db_path;
+    std::string config_path;
+    bool compact_history = false;
+    bool tiered_history = false;
+    bool write_behind = false;
+    std::string dashboard_dir;
+    bool percentiles = false;
+    std::string checkpoint_path;
+    time_t checkpoint_interval = CHECKPOINT_INTERVAL;
+    int listen_port = 0;
+    std::string metrics_path;
+    TelemetryFormat ingest_format = TelemetryFormat::CSV;
+    bool bench = false;
+    bool simulate = false;
+    SimulationOptions simulation;
+    size_t bench_max = 1000000;
+    int bench_reps = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--csv" || arg == "--binary") && i + 1 < argc) {
+            ingest_format = arg == "--csv" ? TelemetryFormat::CSV : TelemetryFormat::BINARY;
+            ingest_path = argv[++i];
+        } else if (arg == "--db" && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--compact") {
+            compact_history = true;
+        } else if (arg == "--tiered") {
+            tiered_history = true;
+        } else if (arg == "--write-behind") {
+            write_behind = true;
+        } else if (arg == "--dashboard" && i + 1 < argc) {
+            dashboard_dir = argv[++i];
+        } else if (arg == "--percentiles") {
+            percentiles = true;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            checkpoint_interval = std::max(0, std::atoi(argv[++i]));
+#if SOLAR_ENABLE_METRICS
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics_path = argv[++i];
+#endif
+#ifdef __linux__
+        } else if (arg == "--listen" && i + 1 < argc) {
+            listen_port = std::atoi(argv[++i]);
+            if (listen_port <= 0 || listen_port > 65535) {
+                printUsage(argv[0]);
+                return 1;
+            }
+#endif
+        } else if (arg == "--bench") {
+            bench = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                bench_max = static_cast<size_t>(std::strtod(argv[++i], nullptr));
+            }
+        } else if (arg == "--simulate" && i + 1 < argc) {
+            simulate = true;
+            simulation.sites = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--days" && i + 1 < argc) {
+            simulation.days = std::max(0.0, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--step" && i + 1 < argc) {
+            simulation.step = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            simulation.rate = std::max(0.0, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--workers" && i + 1 < argc) {
+            simulation.workers = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--reps" && i + 1 < argc) {
+            bench_reps = std::max(1, std::atoi(argv[++i]));
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (bench) {
+        runBenchmarks(bench_max, bench_reps);
+        return 0;
+    }
+
+    if (simulate) {
+        if (compact_history) simulation.make_db = [](uint32_t) { return std::make_unique<CompactDB>(); };
+        if (tiered_history) simulation.make_db = [](uint32_t) { return std::make_unique<TieredDB>(); };
+        runSimulation(simulation);
+        return 0;
+    }
+
+    SiteConfig site;
+    std::unique_ptr<Database> db;
+    std::unique_ptr<DashboardWriter> dashboard;
+    try {
+        if (!config_path.empty()) site = SiteConfig::load(config_path);
+        if (!db_path.empty()) db = std::make_unique<MappedLogDB>(db_path);
+        if (!dashboard_dir.empty()) dashboard = std::make_unique<DashboardWriter>(dashboard_dir);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (!ingest_path.empty() || listen_port > 0) {
+        if (!db && compact_history) db = std::make_unique<CompactDB>();
+        if (!db && tiered_history) db = std::make_unique<TieredDB>();
+        if (!db) db = std::make_unique<ColumnarDB>();
+        if (write_behind) db = std::make_unique<WriteBehindDB>(std::move(db));
+        SolarOptimizer optimizer(std::move(db), 0, site);
+        std::unique_ptr<Checkpointer> checkpointer;
+        if (!checkpoint_path.empty()) {
+            checkpointer = std::make_unique<Checkpointer>(checkpoint_path, checkpoint_interval);
+            try {
+                restoreCheckpoint(optimizer, *checkpointer);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+#ifdef __linux__
+        if (listen_port > 0) {
+            if (!runServer(optimizer, static_cast<uint16_t>(listen_port), dashboard.get(), checkpointer.get(),
+                           metrics_path)) return 1;
+        } else
+#endif
+        if (!runIngest(optimizer, ingest_path, ingest_format, dashboard.get(), checkpointer.get())) return 1;
+        if (checkpointer) {
+            checkpointer->checkpoint(optimizer);
+            checkpointer->flush();
+        }
+        writeMetrics(metrics_path);
+        optimizer.printMaintenanceAlerts();
+        if (percentiles) {
+            printPercentiles(std::cout, optimizer.quantileStore().query(std::numeric_limits<time_t>::min(),
+                                                                       std::numeric_limits<time_t>::max()));
+        }
+        optimizer.generateEnvironmentalReport();
+        return 0;
+    }
+
+    if (!db) db = std::make_unique<MockDB>();
+    SolarOptimizer optimizer(std::move(db), 0, site);
+    runInteractive(optimizer);
+    if (dashboard) dashboard->update(optimizer.rollupStore());
+    writeMetrics(metrics_path);
+
+    // Generate reports
+    optimizer.printMaintenanceAlerts();
+    optimizer.generateEnvironmentalReport();
+
+    return 0;
+}